@@ -9,6 +9,9 @@
 #include <Palette.H>
 #include <AMReX_DataServices.H>
 #include <ProjectionPicture.H>
+#include <ImageKernels.H>
+#include <FrameCache.H>
+#include <GridIndex.H>
 
 using std::cout;
 using std::cerr;
@@ -362,21 +365,19 @@ void AmrPicture::AmrPictureInit() {
     cerr << "*** imageSizeV = " << imageSizeV << endl;
     amrex::Abort("Error in AmrPicture:  Image size too large.  Exiting.");
   }
-  int widthpad = gaPtr->PBitmapPaddedWidth(imageSizeH);
-  imageSize = imageSizeV * widthpad * gaPtr->PBytesPerPixel();
 
   imageData.resize(numberOfLevels);
-  scaledImageData.resize(numberOfLevels);
   for(iLevel = 0; iLevel < minDrawnLevel; ++iLevel) {
-    imageData[iLevel]       = nullptr;
-    scaledImageData[iLevel] = nullptr;
+    imageData[iLevel] = nullptr;
   }
   for(iLevel = minDrawnLevel; iLevel <= maxAllowableLevel; ++iLevel) {
     imageData[iLevel] = new unsigned char[dataSize[iLevel]];
     BL_ASSERT(imageData[iLevel] != nullptr);
-    scaledImageData[iLevel] = new unsigned char[imageSize];
-    BL_ASSERT(scaledImageData[iLevel] != nullptr);
   }
+  levelDataValid.resize(numberOfLevels, false);
+  levelIndexValid.resize(numberOfLevels, false);
+  levelImageValid.resize(numberOfLevels, false);
+  lastDrawnLevel = -1;
   //scaledImageDataBodyMask = nullptr;
 
   pendingTimeOut = 0;
@@ -390,6 +391,8 @@ void AmrPicture::AmrPictureInit() {
   subcutX = 0;
   subcut2ndX = 0;
   framesMade = false;
+  frameXImage = nullptr;
+  exposeDamage = nullptr;
   if(myView == Amrvis::XZ) {
     hColor = AVGlobals::MaxPaletteIndex();
     vColor = 65;
@@ -450,15 +453,10 @@ void AmrPicture::SetHVLine(int scale) {
 AmrPicture::~AmrPicture() {
   int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
   int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
-  if(framesMade) {
-    for(int isl(0); isl < subDomain[maxAllowableLevel].length(sliceDir); ++isl) {
-      XDestroyImage(frameBuffer[isl]);
-    }
-  }
+  ReleaseFrames();
   for(int iLevel(minDrawnLevel); iLevel <= maxAllowableLevel; ++iLevel) {
+    ReleaseLevelImage(iLevel);
     delete [] imageData[iLevel];
-    //free(scaledImageData[iLevel]);
-    delete [] scaledImageData[iLevel];
     delete sliceFab[iLevel];
     if(dataServicesPtr->AmrDataRef().CartGrid()) {
       delete vfSliceFab[iLevel];
@@ -469,6 +467,9 @@ AmrPicture::~AmrPicture() {
   if(pixMapCreated) {
     XFreePixmap(display, pixMap);
   }
+  if(exposeDamage != nullptr) {
+    XDestroyRegion(exposeDamage);
+  }
 }
 
 
@@ -528,8 +529,10 @@ void AmrPicture::SetSlice(int view, int here) {
     numberOfLevels = maxAllowableLevel + 1;
   }
   Vector<int> nGrids(numberOfLevels);
+  Vector< Vector<int> > sliceGrids(numberOfLevels);
   for(lev = minDrawnLevel; lev <= maxAllowableLevel; ++lev) {
-    nGrids[lev] = amrData.NIntersectingGrids(lev, sliceBox[lev]);
+    GridIndex::Intersecting(amrData.boxArray(lev), sliceBox[lev], sliceGrids[lev]);
+    nGrids[lev] = sliceGrids[lev].size();
     gpArray[lev].resize(nGrids[lev]);
     if(nGrids[lev] == 0 && maxLevelWithGrids == maxAllowableLevel) {
       maxLevelWithGrids = lev - 1;
@@ -549,25 +552,23 @@ void AmrPicture::SetSlice(int view, int here) {
   int gridNumber;
   for(lev = minDrawnLevel; lev <= maxLevelWithGrids; ++lev) {
     gridNumber = 0;
-    for(int iBox(0); iBox < amrData.boxArray(lev).size(); ++iBox) {
-      Box temp(amrData.boxArray(lev)[iBox]);
-      if(sliceBox[lev].intersects(temp)) {
-	temp &= sliceBox[lev];
-	Box sliceDataBox(temp);
-	temp.shift(Amrvis::XDIR, -subDomain[lev].smallEnd(Amrvis::XDIR));
+    for(int iGrid(0); iGrid < sliceGrids[lev].size(); ++iGrid) {
+      Box temp(amrData.boxArray(lev)[sliceGrids[lev][iGrid]]);
+      temp &= sliceBox[lev];
+      Box sliceDataBox(temp);
+      temp.shift(Amrvis::XDIR, -subDomain[lev].smallEnd(Amrvis::XDIR));
 #if (BL_SPACEDIM > 1)
-	temp.shift(Amrvis::YDIR, -subDomain[lev].smallEnd(Amrvis::YDIR));
+      temp.shift(Amrvis::YDIR, -subDomain[lev].smallEnd(Amrvis::YDIR));
 #endif
 #if (BL_SPACEDIM == 3)
-	  temp.shift(Amrvis::ZDIR, -subDomain[lev].smallEnd(Amrvis::ZDIR));
+      temp.shift(Amrvis::ZDIR, -subDomain[lev].smallEnd(Amrvis::ZDIR));
 #endif
-        gpArray[lev][gridNumber].GridPictureInit(lev,
+      gpArray[lev][gridNumber].GridPictureInit(lev,
 		amrex::CRRBetweenLevels(lev, maxAllowableLevel,
 		                            amrData.RefRatio()),
 		pltAppStatePtr->CurrentScale(), imageSizeH, imageSizeV,
 		temp, sliceDataBox, sliceDir);
-        ++gridNumber;
-      }
+      ++gridNumber;
     }
   }
 }  // end SetSlice(...)
@@ -580,30 +581,11 @@ void AmrPicture::APChangeContour(Amrvis::ContourType prevCType) {
   pltAppStatePtr->GetMinMax(minUsing, maxUsing);
   int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
   int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
-  FArrayBox *vffp;
-  Real vfeps(0.0);
 
   if(DrawRaster(cType) != DrawRaster(prevCType)) {  // recreate the raster image
-    AmrData &amrData = dataServicesPtr->AmrDataRef();
     for(int iLevel(minDrawnLevel); iLevel <= maxAllowableLevel; ++iLevel) {
-      if(dataServicesPtr->AmrDataRef().CartGrid()) {
-        vfeps = dataServicesPtr->AmrDataRef().VfEps(iLevel);
-	vffp = vfSliceFab[iLevel];
-      } else {
-        vfeps = 0.0;
-	vffp  = NULL;
-      }
-      CreateImage(*(sliceFab[iLevel]), imageData[iLevel],
- 		  dataSizeH[iLevel], dataSizeV[iLevel],
- 	          minUsing, maxUsing, palPtr,
-		  vffp, vfeps);
-      bool bCreateMask(iLevel == minDrawnLevel);
-      CreateScaledImage(&(xImageArray[iLevel]), pltAppStatePtr->CurrentScale() *
-                 amrex::CRRBetweenLevels(iLevel, maxAllowableLevel,
-		                             amrData.RefRatio()),
-                 imageData[iLevel], scaledImageData[iLevel],
-                 dataSizeH[iLevel], dataSizeV[iLevel],
-                 imageSizeH, imageSizeV, iLevel, bCreateMask);
+      levelIndexValid[iLevel] = false;
+      levelImageValid[iLevel] = false;
     }
     if( ! pltAppPtr->PaletteDrawn()) {
       pltAppPtr->PaletteDrawn(true);
@@ -617,8 +599,6 @@ void AmrPicture::APChangeContour(Amrvis::ContourType prevCType) {
 
 // ---------------------------------------------------------------------
 void AmrPicture::DrawBoxes(Vector< Vector<GridPicture> > &gp, Drawable &drawable) {
-  short xbox, ybox;
-  unsigned short wbox, hbox;
   bool bIsWindow(true);
   bool bIsPixmap(false);
   const AmrData &amrData = dataServicesPtr->AmrDataRef();
@@ -636,12 +616,10 @@ void AmrPicture::DrawBoxes(Vector< Vector<GridPicture> > &gp, Drawable &drawable
       if(amrData.Terrain()) {
 	DrawTerrBoxes(level, bIsWindow, bIsPixmap);
       } else {
-        for(int i(0); i < gp[level].size(); ++i) {
-	  xbox = gp[level][i].HPositionInPicture();
-	  ybox = gp[level][i].VPositionInPicture();
-	  wbox = gp[level][i].ImageSizeH(); 
-	  hbox = gp[level][i].ImageSizeV(); 
-          XDrawRectangle(display, drawable, xgc, xbox, ybox, wbox, hbox);
+        Vector<XSegment> segments;
+        GridOutlines(gp[level], segments);
+        if(segments.size() > 0) {
+          XDrawSegments(display, drawable, xgc, segments.dataPtr(), segments.size());
         }
       }
     }
@@ -652,6 +630,22 @@ void AmrPicture::DrawBoxes(Vector< Vector<GridPicture> > &gp, Drawable &drawable
 }
 
 
+// ---------------------------------------------------------------------
+void AmrPicture::GridOutlines(const Vector<GridPicture> &gp,
+                              Vector<XSegment> &segments) const
+{
+  Vector<XRectangle> rects(gp.size());
+  for(int i(0); i < gp.size(); ++i) {
+    rects[i].x      = gp[i].HPositionInPicture();
+    rects[i].y      = gp[i].VPositionInPicture();
+    rects[i].width  = gp[i].ImageSizeH();
+    rects[i].height = gp[i].ImageSizeV();
+  }
+  AVImage::RectangleOutlines(rects.dataPtr(), rects.size(),
+                             imageSizeH, imageSizeV, segments);
+}
+
+
 // ---------------------------------------------------------------------
 void AmrPicture::DrawTerrBoxes(int /*level*/, bool /*bIsWindow*/, bool /*bIsPixmap*/) {
   cerr << endl;
@@ -662,18 +656,31 @@ void AmrPicture::DrawTerrBoxes(int /*level*/, bool /*bIsWindow*/, bool /*bIsPixm
 
 
 // ---------------------------------------------------------------------
-void AmrPicture::APDraw(int /*fromLevel*/, int toLevel) {
+void AmrPicture::APDraw(int fromLevel, int toLevel) {
   if( ! pixMapCreated) {
     pixMap = XCreatePixmap(display, pictureWindow,
 			   imageSizeH, imageSizeV, gaPtr->PDepth());
     pixMapCreated = true;
   }  
+
+  // ---- build the shown level if needed, the smoothing needs the
+  // ---- coarsest level for the body mask
+  MakeLevelImages(bCartGridSmoothing ? fromLevel : toLevel, toLevel);
+  if(toLevel != lastDrawnLevel) {
+    ReleaseLevelImages(toLevel, lastDrawnLevel);
+    lastDrawnLevel = toLevel;
+  }
  
-  XPutImage(display, pixMap, xgc, xImageArray[toLevel], 0, 0, 0, 0,
-	    imageSizeH, imageSizeV);
+  gaPtr->PutImage(pixMap, xgc, xImageArray[toLevel], 0, 0, 0, 0,
+	          imageSizeH, imageSizeV);
            
   Amrvis::ContourType cType(pltAppStatePtr->GetContourType());
   if(DrawContours(cType)) {
+    for(int iLevel(fromLevel); iLevel <= toLevel; ++iLevel) {
+      if( ! levelDataValid[iLevel]) {
+        FillLevelData(iLevel);
+      }
+    }
     DrawContour(sliceFab, display, pixMap, xgc);
   } else if(cType == Amrvis::VECTORS) {
     DrawVectorField(display, pixMap, xgc);
@@ -720,13 +727,62 @@ void AmrPicture::SetSubCut(int startX, int startY, int endX, int endY) {
 
 // ---------------------------------------------------------------------
 void AmrPicture::DoExposePicture() {
+  XRectangle area;
+  area.x = 0;
+  area.y = 0;
+  area.width  = imageSizeH;
+  area.height = imageSizeV;
+  RepaintPicture(area);
+}
+
+
+// ---------------------------------------------------------------------
+void AmrPicture::DoExposePicture(const XExposeEvent &xexpose) {
+  XRectangle exposed;
+  exposed.x = xexpose.x;
+  exposed.y = xexpose.y;
+  exposed.width  = xexpose.width;
+  exposed.height = xexpose.height;
+  if(exposeDamage == nullptr) {
+    exposeDamage = XCreateRegion();
+  }
+  XUnionRectWithRegion(&exposed, exposeDamage, exposeDamage);
+  if(xexpose.count > 0) {  // ---- more are coming
+    return;
+  }
+
+  // ---- the gc clips to the damage, so only the exposed
+  // ---- rectangles are copied and drawn over
+  XRectangle area;
+  XClipBox(exposeDamage, &area);
+  int areaEndH(std::min(area.x + area.width,  static_cast<int>(imageSizeH)));
+  int areaEndV(std::min(area.y + area.height, static_cast<int>(imageSizeV)));
+  if(areaEndH > area.x && areaEndV > area.y) {
+    area.width  = areaEndH - area.x;
+    area.height = areaEndV - area.y;
+    XSetRegion(display, xgc, exposeDamage);
+    RepaintPicture(area);
+    XSetClipMask(display, xgc, None);
+  }
+  XDestroyRegion(exposeDamage);
+  exposeDamage = nullptr;
+}
+
+
+// ---------------------------------------------------------------------
+// ---- repaint area of the picture from the pixmap and draw the
+// ---- overlays over it
+void AmrPicture::RepaintPicture(const XRectangle &area) {
+  const CachedFrame *animFrame(nullptr);
   if(pltAppPtr->Animating()) {
-    XPutImage(display, pictureWindow, xgc, pltAppPtr->CurrentFrameXImage(),
-              0, 0, 0, 0, imageSizeH, imageSizeV);
+    animFrame = pltAppPtr->CurrentFrame();
+  }
+  if(animFrame != nullptr) {
+    PutCachedFrame(*animFrame, area);
   } else {
     if(pendingTimeOut == 0) {
-      XCopyArea(display, pixMap, pictureWindow, 
- 		xgc, 0, 0, imageSizeH, imageSizeV, 0, 0); 
+      XCopyArea(display, pixMap, pictureWindow, xgc,
+ 		area.x, area.y, area.width, area.height, area.x, area.y); 
 
       DrawBoxes(gpArray, pictureWindow);
 
@@ -788,7 +844,7 @@ void AmrPicture::DoExposePicture() {
 #endif
     }
   }
-}  // end DoExposePicture
+}  // end RepaintPicture
 
 
 // ---------------------------------------------------------------------
@@ -813,25 +869,17 @@ void AmrPicture::CreatePicture(Window drawPictureHere, Palette *palptr) {
 void AmrPicture::APMakeImages(Palette *palptr) {
   BL_ASSERT(palptr != NULL);
   palPtr = palptr;
-  AmrData &amrData = dataServicesPtr->AmrDataRef();
   if(UsingFileRange(pltAppStatePtr->GetMinMaxRangeType())) {
     pltAppPtr->PaletteDrawn(false);
   }
 
   int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
   int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
-  if(framesMade) {
-    for(int i(0); i < subDomain[maxAllowableLevel].length(sliceDir); ++i) {
-      XDestroyImage(frameBuffer[i]);
-    }
-    framesMade = false;
-  }
+  ReleaseFrames();
   if(pendingTimeOut != 0) {
     DoStop();
   }
 
-  FArrayBox *vffp;
-  Real vfeps(0.0);
   Real minUsing, maxUsing;
   pltAppStatePtr->GetMinMax(minUsing, maxUsing);
   VSHOWVAL(AVGlobals::Verbose(), minUsing)
@@ -839,46 +887,159 @@ void AmrPicture::APMakeImages(Palette *palptr) {
   VSHOWVAL(AVGlobals::Verbose(), minDrawnLevel)
   VSHOWVAL(AVGlobals::Verbose(), maxAllowableLevel)
 
+  // ---- everything is stale now.  only the displayed level is rebuilt
+  // ---- (by APDraw), the others are rebuilt when they are shown.
+  int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
+  for(int iLevel(minDrawnLevel); iLevel <= maxAllowableLevel; ++iLevel) {
+    levelDataValid[iLevel]  = false;
+    levelIndexValid[iLevel] = false;
+    levelImageValid[iLevel] = false;
+  }
+  ReleaseLevelImages(maxDrawnLevel, maxDrawnLevel);
+
+  if( ! pltAppPtr->PaletteDrawn()) {
+    pltAppPtr->PaletteDrawn(true);
+    palptr->DrawPalette(minUsing, maxUsing, pltAppStatePtr->GetFormatString());
+  }
+  APDraw(minDrawnLevel, maxDrawnLevel);
+
+}  // end AP Make Images
+
+
+// ---------------------------------------------------------------------
+void AmrPicture::FillLevelData(int iLevel) {
   const string currentDerived(pltAppStatePtr->CurrentDerived());
   const string vfracDerived("vfrac");
-  for(int iLevel(minDrawnLevel); iLevel <= maxAllowableLevel; ++iLevel) {
+  amrex::DataServices::Dispatch(amrex::DataServices::FillVarOneFab, dataServicesPtr,
+		         (void *) (sliceFab[iLevel]),
+			 (void *) (&(sliceFab[iLevel]->box())),
+			 iLevel,
+			 (void *) &currentDerived);
+  if(dataServicesPtr->AmrDataRef().CartGrid()) {
+    BL_ASSERT(vfSliceFab[iLevel]->box() == sliceFab[iLevel]->box());
     amrex::DataServices::Dispatch(amrex::DataServices::FillVarOneFab, dataServicesPtr,
-		           (void *) (sliceFab[iLevel]),
-			   (void *) (&(sliceFab[iLevel]->box())),
+		           (void *) (vfSliceFab[iLevel]),
+			   (void *) (&(vfSliceFab[iLevel]->box())),
 			   iLevel,
-			   (void *) &currentDerived);
+			   (void *) &vfracDerived);
+  }
+  levelDataValid[iLevel] = true;
+}
+
+
+// ---------------------------------------------------------------------
+// ---- make the slice images for the levels in [fromLevel, toLevel]
+// ---- that are not current.  the fab reads go through DataServices
+// ---- and the XImages are created through GraphicsAttributes, so both
+// ---- stay on this thread in level order.  the quantize and scale work for each
+// ---- level is handed off as a task as soon as its data is read, so
+// ---- it overlaps the reads of the next levels.  the body smoothing
+// ---- shares the body mask across levels, so it runs inline.
+void AmrPicture::MakeLevelImages(int fromLevel, int toLevel) {
+  AmrData &amrData = dataServicesPtr->AmrDataRef();
+  int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
+  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+  int currentScale(pltAppStatePtr->CurrentScale());
+  Real minUsing, maxUsing;
+  pltAppStatePtr->GetMinMax(minUsing, maxUsing);
+
+  double time0(ParallelDescriptor::second());
+  int nMade(0);
+  long nQuantized(0);
+  double quantizeTime(0.0);  // ---- summed over the tasks
+#ifdef _OPENMP
+#pragma omp parallel
+#pragma omp master
+#endif
+  for(int iLevel(fromLevel); iLevel <= toLevel; ++iLevel) {
+    if(levelImageValid[iLevel]) {
+      continue;
+    }
+    if( ! levelDataValid[iLevel]) {
+      FillLevelData(iLevel);
+    }
+    FArrayBox *vffp(NULL);
+    Real vfeps(0.0);
     if(amrData.CartGrid()) {
-      BL_ASSERT(vfSliceFab[iLevel]->box() == sliceFab[iLevel]->box());
-      amrex::DataServices::Dispatch(amrex::DataServices::FillVarOneFab, dataServicesPtr,
-		             (void *) (vfSliceFab[iLevel]),
-			     (void *) (&(vfSliceFab[iLevel]->box())),
-			     iLevel,
-			     (void *) &vfracDerived);
-      vfeps = dataServicesPtr->AmrDataRef().VfEps(iLevel);
-      vffp = vfSliceFab[iLevel];
-    } else {
-      vfeps = 0.0;
-      vffp  = NULL;
+      vfeps = amrData.VfEps(iLevel);
+      vffp  = vfSliceFab[iLevel];
+    }
+    bool bMakeIndex( ! levelIndexValid[iLevel]);
+    if(xImageArray[iLevel] == nullptr) {  // ---- else refilled at the same size
+      xImageArray[iLevel] = gaPtr->CreateImage(imageSizeH, imageSizeV);
     }
-    CreateImage(*(sliceFab[iLevel]), imageData[iLevel],
- 		dataSizeH[iLevel], dataSizeV[iLevel],
- 	        minUsing, maxUsing, palPtr, vffp, vfeps);
     bool bCreateMask(iLevel == minDrawnLevel);
-    CreateScaledImage(&(xImageArray[iLevel]), pltAppStatePtr->CurrentScale() *
-                amrex::CRRBetweenLevels(iLevel, maxAllowableLevel,
-		amrData.RefRatio()),
-                imageData[iLevel], scaledImageData[iLevel],
-                dataSizeH[iLevel], dataSizeV[iLevel],
-                imageSizeH, imageSizeV, iLevel, bCreateMask);
+    int scale(currentScale * amrex::CRRBetweenLevels(iLevel, maxAllowableLevel,
+                                                     amrData.RefRatio()));
+#ifdef _OPENMP
+#pragma omp task firstprivate(iLevel, vffp, vfeps, bMakeIndex, bCreateMask, scale) \
+                 if( ! bCartGridSmoothing)
+#endif
+    {
+      if(bMakeIndex) {
+        double qtime0(ParallelDescriptor::second());
+        CreateImage(*(sliceFab[iLevel]), imageData[iLevel],
+ 		    dataSizeH[iLevel], dataSizeV[iLevel],
+ 	            minUsing, maxUsing, palPtr, vffp, vfeps);
+        double qtime(ParallelDescriptor::second() - qtime0);
+        long ncells(static_cast<long>(dataSizeH[iLevel]) * dataSizeV[iLevel]);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        quantizeTime += qtime;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        nQuantized += ncells;
+      }
+      FillScaledImage(xImageArray[iLevel], scale,
+                      imageData[iLevel],
+                      dataSizeH[iLevel], dataSizeV[iLevel],
+                      imageSizeH, imageSizeV, iLevel, bCreateMask);
+    }
+    levelIndexValid[iLevel] = true;
+    levelImageValid[iLevel] = true;
+    ++nMade;
+  }  // ---- the tasks are done at the end of the parallel region
+
+  if(AVGlobals::Verbose() && nMade > 0) {
+    cout << "_in MakeLevelImages:  " << nMade << " level image(s) in ["
+         << fromLevel << ", " << toLevel << "] made in "
+         << ParallelDescriptor::second() - time0 << " s" << endl;
+    if(nQuantized > 0) {
+      cout << "_in MakeLevelImages:  " << nQuantized << " cells quantized in "
+           << quantizeTime << " s" << endl;
+    }
   }
-  if( ! pltAppPtr->PaletteDrawn()) {
-    pltAppPtr->PaletteDrawn(true);
-    palptr->DrawPalette(minUsing, maxUsing, pltAppStatePtr->GetFormatString());
+}
+
+
+// ---------------------------------------------------------------------
+// ---- free the scaled images of all levels except keepLevelA and
+// ---- keepLevelB (and the coarsest level when smoothing, since it
+// ---- builds the body mask).  only the shown and the previously shown
+// ---- levels are held, so switching between two levels is immediate
+// ---- without holding a full size image for every level.
+void AmrPicture::ReleaseLevelImages(int keepLevelA, int keepLevelB) {
+  int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
+  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+  for(int iLevel(minDrawnLevel); iLevel <= maxAllowableLevel; ++iLevel) {
+    if(iLevel == keepLevelA || iLevel == keepLevelB ||
+       (bCartGridSmoothing && iLevel == minDrawnLevel))
+    {
+      continue;
+    }
+    ReleaseLevelImage(iLevel);
   }
-  int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
-  APDraw(minDrawnLevel, maxDrawnLevel);
+}
 
-}  // end AP Make Images
+
+// ---------------------------------------------------------------------
+void AmrPicture::ReleaseLevelImage(int iLevel) {
+  gaPtr->DestroyImage(xImageArray[iLevel]);
+  xImageArray[iLevel] = nullptr;
+  levelImageValid[iLevel] = false;
+}
 
 
 // -------------------------------------------------------------------
@@ -888,14 +1049,6 @@ void AmrPicture::CreateImage(const FArrayBox &fab, unsigned char *imagedata,
 			     Real globalMin, Real globalMax, Palette *palptr,
 			     const FArrayBox *vfracFab, const Real vfeps)
 {
-  int jdsh, jtmp1;
-  int dIndex, iIndex;
-  Real oneOverGDiff;
-  if((globalMax - globalMin) < FLT_MIN) {
-    oneOverGDiff = 0.0;
-  } else {
-    oneOverGDiff = 1.0 / (globalMax - globalMin);
-  }
   const Real *dataPoint = fab.dataPtr();
   bool bCartGrid(dataServicesPtr->AmrDataRef().CartGrid());
   const Real *vfDataPoint = 0;
@@ -907,59 +1060,21 @@ void AmrPicture::CreateImage(const FArrayBox &fab, unsigned char *imagedata,
   
   // flips the image in Vert dir: j => datasizev-j-1
   if(DrawRaster(pltAppStatePtr->GetContourType())) {
-    Real dPoint;
     int paletteStart(palptr->PaletteStart());
     int paletteEnd(palptr->PaletteEnd());
     int colorSlots(palptr->ColorSlots());
     int csm1(colorSlots - 1);
     if(bCartGrid == false || (bCartGrid && AVGlobals::GetShowBody() == false)) {
-      for(int j(0); j < datasizev; ++j) {
-        jdsh = j * datasizeh;
-        jtmp1 = (datasizev-j-1) * datasizeh;
-        for(int i(0); i < datasizeh; ++i) {
-          dIndex = i + jtmp1;
-          dPoint = dataPoint[dIndex];
-          iIndex = i + jdsh;
-          if(dPoint > globalMax) {  // clip
-            imagedata[iIndex] = paletteEnd;
-          } else if(dPoint < globalMin) {  // clip
-            imagedata[iIndex] = paletteStart;
-          } else {
-            imagedata[iIndex] = (unsigned char)
-              ((((dPoint - globalMin) * oneOverGDiff) * csm1) );
-              //  ^^^^^^^^^^^^^^^^^^ Real data
-            imagedata[iIndex] += paletteStart;
-          } 
-        }
-      }
+      AVImage::QuantizeToIndex(dataPoint, imagedata, datasizeh, datasizev,
+                               globalMin, globalMax, csm1,
+                               paletteStart, paletteEnd);
     } else {  // mask the body
       int bodyColor(palptr->BlackIndex());
-      Real dVFPoint;
-      for(int j(0); j < datasizev; ++j) {
-        jdsh = j * datasizeh;
-        jtmp1 = (datasizev-j-1) * datasizeh;
-        for(int i(0); i < datasizeh; ++i) {
-          dIndex = i + jtmp1;
-          dPoint = dataPoint[dIndex];
-          dVFPoint = vfDataPoint[dIndex];
-          iIndex = i + jdsh;
-          if(dPoint > globalMax) {  // clip
-            imagedata[iIndex] = paletteEnd;
-          } else if(dPoint < globalMin) {  // clip
-            imagedata[iIndex] = paletteStart;
-          } else {
-            imagedata[iIndex] = (unsigned char)
-              ((((dPoint - globalMin) * oneOverGDiff) * csm1) );
-              //  ^^^^^^^^^^^^^^^^^^ Real data
-            imagedata[iIndex] += paletteStart;
-          } 
-          if(dVFPoint < vfeps) {  // set to body color
-            imagedata[iIndex] = bodyColor;
-	  }
-        }
-      }
+      AVImage::QuantizeToIndexMasked(dataPoint, imagedata, datasizeh, datasizev,
+                                     globalMin, globalMax, csm1,
+                                     paletteStart, paletteEnd,
+                                     vfDataPoint, vfeps, bodyColor);
     }
-
   } else {
 
     if(AVGlobals::LowBlack()) {
@@ -978,28 +1093,17 @@ void AmrPicture::CreateImage(const FArrayBox &fab, unsigned char *imagedata,
 
 
 // ---------------------------------------------------------------------
-void AmrPicture::CreateScaledImage(XImage **ximage, int scale,
-				   unsigned char *imagedata,
-				   unsigned char *scaledimagedata,
-				   int datasizeh, int datasizev,
-				   int imagesizeh, int imagesizev,
-				   int level, bool bCreateMask)
+// ---- fill an XImage made by GraphicsAttributes::CreateImage.  this
+// ---- makes no X server calls, so it can run off the main thread.
+void AmrPicture::FillScaledImage(XImage *ximage, int scale,
+				 const unsigned char *imagedata,
+				 int datasizeh, int datasizev,
+				 int imagesizeh, int imagesizev,
+				 int level, bool bCreateMask)
 { 
-  int widthpad = gaPtr->PBitmapPaddedWidth(imagesizeh);
-  *ximage = XCreateImage(display, gaPtr->PVisual(),
-		gaPtr->PDepth(), ZPixmap, 0, (char *) scaledimagedata,
-		widthpad, imagesizev,
-		XBitmapPad(display), widthpad * gaPtr->PBytesPerPixel());
-
   if( ! bCartGridSmoothing) {
-    for(int j(0); j < imagesizev; ++j) {
-      int jtmp(datasizeh * (j/scale));
-      for(int i(0); i < widthpad; ++i) {
-        int itmp(i / scale);
-        unsigned char imm1(imagedata[ itmp + jtmp ]);
-        XPutPixel(*ximage, i, j, palPtr->makePixel(imm1));
-      }
-    }
+    AVImage::WriteScaledImage(ximage, imagedata, datasizeh, datasizev,
+                              scale, *palPtr);
 
   } else {  // bCartGridSmoothing
 
@@ -1397,21 +1501,15 @@ void AmrPicture::CreateScaledImage(XImage **ximage, int scale,
   }  // ---- end create body mask
 
     // ---- fill with image data
-    for(int jjss(0); jjss < imagesizev; ++jjss) {
-      int jtmp(datasizeh * (jjss/scale));
-      for(int iiss(0); iiss < widthpad; ++iiss) {
-        int itmp(iiss / scale);
-        unsigned char imm1(imagedata[ itmp + jtmp ]);
-        XPutPixel(*ximage, iiss, jjss, palPtr->makePixel(imm1));
-      }
-    }
+    AVImage::WriteScaledImage(ximage, imagedata, datasizeh, datasizev,
+                              scale, *palPtr);
     // ---- mask the smoothed body cells
     for(int jjss(0); jjss < imagesizev; ++jjss) {
       for(int iiss(0); iiss < imagesizeh; ++iiss) {
 	int index(iiss + (imagesizev-1-jjss)*imagesizeh);
         if(scaledImageDataBodyMask[index] == 0) {
 	  int iii(iiss), jjj(imagesizev-1-jjss);
-	  XPutPixel(*ximage, iii, jjj, palPtr->makePixel(bodyColor));
+	  XPutPixel(ximage, iii, jjj, palPtr->makePixel(bodyColor));
 	}
       }
     }
@@ -1427,19 +1525,12 @@ void AmrPicture::APChangeScale(int newScale, int previousScale) {
   int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
   int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
   int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
-  if(framesMade) {
-    for(int i(0); i < subDomain[maxAllowableLevel].length(sliceDir); ++i) {
-      XDestroyImage(frameBuffer[i]);
-    }
-    framesMade = false;
-  }
+  ReleaseFrames();
   if(pendingTimeOut != 0) {
     DoStop();
   }
   imageSizeH = newScale   * dataSizeH[maxAllowableLevel];
   imageSizeV = newScale   * dataSizeV[maxAllowableLevel];
-  int widthpad = gaPtr->PBitmapPaddedWidth(imageSizeH);
-  imageSize  = widthpad * imageSizeV * gaPtr->PBytesPerPixel();
   XClearWindow(display, pictureWindow);
 
   if(pixMapCreated) {
@@ -1455,19 +1546,10 @@ void AmrPicture::APChangeScale(int newScale, int previousScale) {
    }
   }
 
-  AmrData &amrData = dataServicesPtr->AmrDataRef();
-
+  // ---- the index images are still good, the scaled images are the
+  // ---- wrong size.  APDraw rebuilds the shown level.
   for(iLevel = minDrawnLevel; iLevel <= maxAllowableLevel; ++iLevel) {
-    bool bCreateMask(iLevel == minDrawnLevel);
-    delete [] scaledImageData[iLevel];
-    scaledImageData[iLevel] = new unsigned char[imageSize];
-    BL_ASSERT(scaledImageData[iLevel] != nullptr);
-    CreateScaledImage(&xImageArray[iLevel], newScale *
-                amrex::CRRBetweenLevels(iLevel, maxAllowableLevel,
-		amrData.RefRatio()),
-                imageData[iLevel], scaledImageData[iLevel],
-                dataSizeH[iLevel], dataSizeV[iLevel],
-                imageSizeH, imageSizeV, iLevel, bCreateMask);
+    ReleaseLevelImage(iLevel);
   }
 
   hLine = ((hLine / previousScale) * newScale) + (newScale - 1);
@@ -1478,13 +1560,7 @@ void AmrPicture::APChangeScale(int newScale, int previousScale) {
 
 // ---------------------------------------------------------------------
 void AmrPicture::APChangeLevel() { 
-  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
-  if(framesMade) {
-    for(int i(0); i < subDomain[maxAllowableLevel].length(sliceDir); ++i) {
-      XDestroyImage(frameBuffer[i]);
-    }
-    framesMade = false;
-  }
+  ReleaseFrames();
   if(pendingTimeOut != 0) {
     DoStop();
   }
@@ -1498,7 +1574,6 @@ void AmrPicture::APChangeLevel() {
 
 // ---------------------------------------------------------------------
 XImage *AmrPicture::GetPictureXImage(const bool bdrawboxesintoimage) {
-  int xbox, ybox, wbox, hbox;
   XImage *ximage;
 
   int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
@@ -1512,13 +1587,10 @@ XImage *AmrPicture::GetPictureXImage(const bool bdrawboxesintoimage) {
         XSetForeground(display, xgc,
 		palPtr->makePixel(palPtr->SafePaletteIndex(level, maxDataLevel)));
       }
-      for(int i(0); i < gpArray[level].size(); ++i) {
-	xbox = gpArray[level][i].HPositionInPicture();
-	ybox = gpArray[level][i].VPositionInPicture();
-	wbox = gpArray[level][i].ImageSizeH(); 
-	hbox = gpArray[level][i].ImageSizeV(); 
-
-        XDrawRectangle(display, pixMap, xgc, xbox, ybox, wbox, hbox);
+      Vector<XSegment> segments;
+      GridOutlines(gpArray[level], segments);
+      if(segments.size() > 0) {
+        XDrawSegments(display, pixMap, xgc, segments.dataPtr(), segments.size());
       }
     }
   }
@@ -1569,150 +1641,477 @@ void AmrPicture::CoarsenSliceBox() {
 
 
 // ---------------------------------------------------------------------
-void AmrPicture::CreateFrames(Amrvis::AnimDirection direction) {
-  char buffer[Amrvis::BUFSIZE];
-  bool cancelled(false);
-  int islice(0), i, j, lev, gridNumber;
-  Vector<int> intersectGrids;
-  int maxLevelWithGridsHere;
+// ---- the maxDrawnLevel box of relative slice iRelSlice
+Box AmrPicture::FrameSliceBox(int iRelSlice) const {
+  const AmrData &amrData = dataServicesPtr->AmrDataRef();
+  int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
+  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+  int start(subDomain[maxAllowableLevel].smallEnd(sliceDir));
+  Box frameBox(subDomain[maxAllowableLevel]);
+  frameBox.setSmall(sliceDir, start + iRelSlice);
+  frameBox.setBig(sliceDir, start + iRelSlice);
+  frameBox.coarsen(amrex::CRRBetweenLevels(maxDrawnLevel, maxAllowableLevel,
+                                           amrData.RefRatio()));
+  return frameBox;
+}
+
+
+// ---------------------------------------------------------------------
+// ---- the relative slices in sweep order, starting at iFirstSlice
+Vector<int> AmrPicture::FrameSweepOrder(int iFirstSlice,
+                                        Amrvis::AnimDirection direction) const
+{
+  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+  int length(subDomain[maxAllowableLevel].length(sliceDir));
   int posneg(1);
   if(direction == Amrvis::ANIMNEGDIR) {
     posneg = -1;
   }
+  Vector<int> frameSlice(length);
+  for(int i(0); i < length; ++i) {
+    frameSlice[i] = (((iFirstSlice + (posneg * i)) + length) % length);
+			          // ^^^^^^^^ + length for negative values
+  }
+  return frameSlice;
+}
+
+
+// ---------------------------------------------------------------------
+// ---- the grid pictures drawn over the frame of relative slice iRelSlice
+void AmrPicture::MakeFrameGrids(int iRelSlice) {
   const AmrData &amrData = dataServicesPtr->AmrDataRef();
   int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
+  int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
   int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+  int start(subDomain[maxAllowableLevel].smallEnd(sliceDir));
 
-  sprintf(buffer, "Creating frames..."); 
-  PrintMessage(buffer);
   Vector<Box> interBox(numberOfLevels);
   interBox[maxAllowableLevel] = subDomain[maxAllowableLevel];
-  int start = subDomain[maxAllowableLevel].smallEnd(sliceDir);
-  int length = subDomain[maxAllowableLevel].length(sliceDir);
-  if(framesMade) {
-    for(int ii(0); ii < subDomain[maxAllowableLevel].length(sliceDir); ++ii) {
-      XDestroyImage(frameBuffer[ii]);
+  interBox[maxAllowableLevel].setSmall(sliceDir, start + iRelSlice);
+  interBox[maxAllowableLevel].setBig(sliceDir, start + iRelSlice);
+  for(int j(maxAllowableLevel - 1); j >= minDrawnLevel; --j) {
+    interBox[j] = interBox[maxAllowableLevel];
+    interBox[j].coarsen(amrex::CRRBetweenLevels(j, maxAllowableLevel,
+			amrData.RefRatio()));
+  }
+  int maxLevelWithGridsHere(maxDrawnLevel);
+  frameGrids[iRelSlice].resize(maxLevelWithGridsHere + 1); 
+  Vector<int> frameGridIndices;
+  for(int lev(minDrawnLevel); lev <= maxLevelWithGridsHere; ++lev) {
+    GridIndex::Intersecting(amrData.boxArray(lev), interBox[lev], frameGridIndices);
+    frameGrids[iRelSlice][lev].resize(frameGridIndices.size());
+    for(int iGrid(0); iGrid < frameGridIndices.size(); ++iGrid) {
+      Box temp(amrData.boxArray(lev)[frameGridIndices[iGrid]]);
+      temp &= interBox[lev];
+      Box sliceDataBox(temp);
+      temp.shift(Amrvis::XDIR, -subDomain[lev].smallEnd(Amrvis::XDIR));
+      temp.shift(Amrvis::YDIR, -subDomain[lev].smallEnd(Amrvis::YDIR));
+      temp.shift(Amrvis::ZDIR, -subDomain[lev].smallEnd(Amrvis::ZDIR));
+      frameGrids[iRelSlice][lev][iGrid].GridPictureInit(lev,
+              amrex::CRRBetweenLevels(lev, maxAllowableLevel,
+	      amrData.RefRatio()),
+              pltAppStatePtr->CurrentScale(), imageSizeH, imageSizeV,
+              temp, sliceDataBox, sliceDir);
     }
   }
-  frameGrids.resize(length); 
-  frameBuffer.resize(length);
+}
+
+
+// ---------------------------------------------------------------------
+// ---- the last frame of the batch starting at frameSlice[iFirst].  the
+// ---- batch is read as one slab of at most AVGlobals::SlabCacheMB()
+// ---- megabytes, stops at the wrap around the domain end so the slab
+// ---- stays contiguous, and fits in the frame cache.
+int AmrPicture::FrameBatchEnd(const Vector<int> &frameSlice, int iFirst) const {
+  bool bCartGrid(dataServicesPtr->AmrDataRef().CartGrid());
+  Box firstBox(FrameSliceBox(frameSlice[iFirst]));
+  long bytesPerSlice(firstBox.numPts() * sizeof(Real) * (bCartGrid ? 2 : 1));
+  long slabCacheBytes(AVGlobals::SlabCacheMB() * 1024L * 1024L);
+  int nSlabSlices(std::max(1L, slabCacheBytes / bytesPerSlice));
   int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
-  unsigned char *frameImageData = new unsigned char[dataSize[maxDrawnLevel]];
-  int iEnd(0);
-  for(i = 0; i < length; ++i) {
-    islice = (((slice - start + (posneg * i)) + length) % length);
-			          // ^^^^^^^^ + length for negative values
-    intersectGrids.resize(maxAllowableLevel + 1);
-    interBox[maxAllowableLevel].setSmall(sliceDir, start+islice);
-    interBox[maxAllowableLevel].setBig(sliceDir, start+islice);
-    for(j = maxAllowableLevel - 1; j >= minDrawnLevel; --j) {
-      interBox[j] = interBox[maxAllowableLevel];
-      interBox[j].coarsen(amrex::CRRBetweenLevels(j, maxAllowableLevel,
-			  amrData.RefRatio()));
+  int nMaxFrames(FrameCache::TheFrameCache().FramesInBudget(dataSize[maxDrawnLevel]));
+
+  int cLo(firstBox.smallEnd(sliceDir)), cHi(cLo);
+  int iLast(iFirst);
+  while(iLast + 1 < frameSlice.size() && iLast + 1 - iFirst < nMaxFrames) {
+    int inext(iLast + 1);
+    if(std::abs(frameSlice[inext] - frameSlice[iLast]) != 1) {
+      break;
     }
-    for(lev = minDrawnLevel; lev <= maxAllowableLevel; ++lev) {
-      intersectGrids[lev] = amrData.NIntersectingGrids(lev, interBox[lev]);
+    int c(FrameSliceBox(frameSlice[inext]).smallEnd(sliceDir));
+    int lo(std::min(cLo, c)), hi(std::max(cHi, c));
+    if(hi - lo + 1 > nSlabSlices) {
+      break;
     }
-    maxLevelWithGridsHere = maxDrawnLevel;
-    frameGrids[islice].resize(maxLevelWithGridsHere + 1); 
-    for(lev = minDrawnLevel; lev <= maxLevelWithGridsHere; ++lev) {
-      frameGrids[islice][lev].resize(intersectGrids[lev]);
-    } 
-
-    for(lev = minDrawnLevel; lev <= maxLevelWithGridsHere; ++lev) {
-      gridNumber = 0;
-      for(int iBox(0); iBox < amrData.boxArray(lev).size(); ++iBox) {
-	Box temp(amrData.boxArray(lev)[iBox]);
-        if(interBox[lev].intersects(temp)) {
-	  temp &= interBox[lev];
-          Box sliceDataBox(temp);
-	  temp.shift(Amrvis::XDIR, -subDomain[lev].smallEnd(Amrvis::XDIR));
-	  temp.shift(Amrvis::YDIR, -subDomain[lev].smallEnd(Amrvis::YDIR));
-          temp.shift(Amrvis::ZDIR, -subDomain[lev].smallEnd(Amrvis::ZDIR));
-          frameGrids[islice][lev][gridNumber].GridPictureInit(lev,
-                  amrex::CRRBetweenLevels(lev, maxAllowableLevel,
-		  amrData.RefRatio()),
-                  pltAppStatePtr->CurrentScale(), imageSizeH, imageSizeV,
-                  temp, sliceDataBox, sliceDir);
-          ++gridNumber;
-        }
-      }
-    }   // end for(lev...)
+    cLo = lo;
+    cHi = hi;
+    ++iLast;
+  }
+  return iLast;
+}
+
 
-    // get the data for this slice
-    const string currentDerived(pltAppStatePtr->CurrentDerived());
-    FArrayBox imageFab(interBox[maxDrawnLevel], 1);
+// ---------------------------------------------------------------------
+// ---- make the index frames for frameSlice[iFirst..iLast] from a single
+// ---- slab read.  the I/O stays on this thread, the frames are
+// ---- quantized and encoded in parallel.
+void AmrPicture::MakeFrameBatch(const Vector<int> &frameSlice, int iFirst, int iLast,
+                                Vector<CachedFrame *> &batchFrames,
+                                double &readTime, double &buildTime)
+{
+  const AmrData &amrData = dataServicesPtr->AmrDataRef();
+  int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
+  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+  int frameScale(pltAppStatePtr->CurrentScale() *
+                 amrex::CRRBetweenLevels(maxDrawnLevel, maxAllowableLevel,
+                                         amrData.RefRatio()));
+  const string currentDerived(pltAppStatePtr->CurrentDerived());
+  const string vfracDerived("vfrac");
+  bool bCartGrid(amrData.CartGrid());
+  Real vfeps(bCartGrid ? amrData.VfEps(maxDrawnLevel) : 0.0);
+  Real minUsing, maxUsing;
+  pltAppStatePtr->GetMinMax(minUsing, maxUsing);
+  int nBatch(iLast - iFirst + 1);
+
+  Vector<Box> frameBox(nBatch);
+  Box slabBox(FrameSliceBox(frameSlice[iFirst]));
+  for(int ib(0); ib < nBatch; ++ib) {
+    frameBox[ib] = FrameSliceBox(frameSlice[iFirst + ib]);
+    slabBox.minBox(frameBox[ib]);
+  }
+
+  double time0(ParallelDescriptor::second());
+  FArrayBox slabFab(slabBox, 1);
+  amrex::DataServices::Dispatch(amrex::DataServices::FillVarOneFab, dataServicesPtr,
+			 (void *) &slabFab,
+			 (void *) (&(slabFab.box())),
+			 maxDrawnLevel,
+                         (void *) &currentDerived);
+  FArrayBox vfSlabFab;
+  if(bCartGrid) {
+    vfSlabFab.resize(slabBox, 1);
     amrex::DataServices::Dispatch(amrex::DataServices::FillVarOneFab, dataServicesPtr,
-			   (void *) &imageFab,
-			   (void *) (&(imageFab.box())),
+		           (void *) &vfSlabFab,
+			   (void *) (&(vfSlabFab.box())),
 			   maxDrawnLevel,
-                           (void *) &currentDerived);
+			   (void *) &vfracDerived);
+  }
+  readTime += ParallelDescriptor::second() - time0;
 
-    Real minUsing, maxUsing;
-    pltAppStatePtr->GetMinMax(minUsing, maxUsing);
+  batchFrames.resize(nBatch);
+  for(int ib(0); ib < nBatch; ++ib) {
+    batchFrames[ib] = new CachedFrame;
+    batchFrames[ib]->scale = frameScale;
+  }
 
+  time0 = ParallelDescriptor::second();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int ib = 0; ib < nBatch; ++ib) {
+    FArrayBox imageFab(frameBox[ib], 1);
+    imageFab.copy(slabFab);
+    FArrayBox vfFab;
     FArrayBox *vffp = NULL;
-    Real vfeps(0.0);
-    const string vfracDerived("vfrac");
-    if(amrData.CartGrid()) {
-      vffp = new FArrayBox(interBox[maxDrawnLevel], 1);
-      amrex::DataServices::Dispatch(amrex::DataServices::FillVarOneFab, dataServicesPtr,
-		             (void *) (vffp),
-			     (void *) (&(vffp->box())),
-			     maxDrawnLevel,
-			     (void *) &vfracDerived);
-      vfeps = dataServicesPtr->AmrDataRef().VfEps(maxDrawnLevel);
-    } else {
-      vfeps = 0.0;
-      vffp  = NULL;
+    if(bCartGrid) {
+      vfFab.resize(frameBox[ib], 1);
+      vfFab.copy(vfSlabFab);
+      vffp = &vfFab;
     }
-    CreateImage(imageFab, frameImageData,
+    Vector<unsigned char> frameImageData(dataSize[maxDrawnLevel]);
+    CreateImage(imageFab, frameImageData.dataPtr(),
 		dataSizeH[maxDrawnLevel], dataSizeV[maxDrawnLevel],
                 minUsing, maxUsing, palPtr, vffp, vfeps);
+    batchFrames[ib]->SetIndexData(frameImageData.dataPtr(),
+                                  dataSizeH[maxDrawnLevel], dataSizeV[maxDrawnLevel]);
+  }
+  buildTime += ParallelDescriptor::second() - time0;
+}
 
-    // this cannot be deleted because it belongs to the XImage
-    unsigned char *frameScaledImageData;
-    frameScaledImageData = (unsigned char *) malloc(imageSize);
 
-    bool bCreateMask(true);
+// ---------------------------------------------------------------------
+// ---- the frame of relative slice iRelSlice from the frame cache.  on a
+// ---- miss the frames ahead in the sweep direction are remade as well.
+CachedFrame *AmrPicture::GetFrame(int iRelSlice) {
+  FrameCache &frameCache = FrameCache::TheFrameCache();
+  CachedFrame *cframe(frameCache.Find(this, iRelSlice));
+  if(cframe == nullptr) {
+    Vector<int> frameSlice(FrameSweepOrder(iRelSlice, sweepDirection));
+    int iLast(FrameBatchEnd(frameSlice, 0));
+    Vector<CachedFrame *> batchFrames;
+    double readTime(0.0), buildTime(0.0);
+    MakeFrameBatch(frameSlice, 0, iLast, batchFrames, readTime, buildTime);
+    // ---- the next frame is inserted last, so it is the most recent
+    // ---- and no later insert of this batch can evict it
+    for(int i(iLast); i >= 0; --i) {
+      frameCache.Insert(this, frameSlice[i], batchFrames[i]);
+    }
+    cframe = frameCache.Peek(this, iRelSlice);
+    BL_ASSERT(cframe == batchFrames[0]);
+    if(AVGlobals::Verbose()) {
+      cout << "_in GetFrame:  remade " << iLast + 1 << " frames:  read time = "
+           << readTime << " s, build time = " << buildTime << " s" << endl;
+    }
+  }
+  return cframe;
+}
 
-    CreateScaledImage(&(frameBuffer[islice]), pltAppStatePtr->CurrentScale() *
-           amrex::CRRBetweenLevels(maxDrawnLevel, maxAllowableLevel,
-	   amrData.RefRatio()),
-           frameImageData, frameScaledImageData,
-           dataSizeH[maxDrawnLevel], dataSizeV[maxDrawnLevel],
-           imageSizeH, imageSizeV, maxDrawnLevel, bCreateMask);
 
-    ShowFrameImage(islice);
-#if (BL_SPACEDIM == 3)
-    
-    if( ! framesMade) {
-      pltAppPtr->GetProjPicturePtr()->ChangeSlice(Amrvis::YZ-sliceDir, islice+start);
-      pltAppPtr->GetProjPicturePtr()->MakeSlices();
-      XClearWindow(XtDisplay(pltAppPtr->GetWTransDA()),
-                   XtWindow(pltAppPtr->GetWTransDA()));
-      pltAppPtr->DoExposeTransDA();
+// ---------------------------------------------------------------------
+void AmrPicture::ReleaseFrames() {
+  FrameCache::TheFrameCache().EraseOwner(this);
+  framesMade = false;
+  gaPtr->DestroyImage(frameXImage);
+  frameXImage = nullptr;
+}
+
+
+// ---------------------------------------------------------------------
+// ---- a frame of the picture as it is drawn now.  a raster picture
+// ---- keeps its index image and grid boxes, anything with overlays in
+// ---- the pixmap keeps the whole picture image.
+CachedFrame *AmrPicture::MakeCachedFrame() {
+  int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
+  int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
+  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+  CachedFrame *cframe = new CachedFrame;
+  if(pltAppStatePtr->GetContourType() != Amrvis::RASTERONLY ||
+     bCartGridSmoothing || ! levelIndexValid[maxDrawnLevel])
+  {
+    cframe->ximage = GetPictureXImage();
+    return cframe;
+  }
+
+  cframe->SetIndexData(imageData[maxDrawnLevel],
+                       dataSizeH[maxDrawnLevel], dataSizeV[maxDrawnLevel]);
+  cframe->scale = pltAppStatePtr->CurrentScale() *
+                  amrex::CRRBetweenLevels(maxDrawnLevel, maxAllowableLevel,
+                                  dataServicesPtr->AmrDataRef().RefRatio());
+  if(pltAppStatePtr->GetShowingBoxes()) {
+    cframe->minBoxLevel = minDrawnLevel;
+    cframe->gridSegments.resize(maxDrawnLevel - minDrawnLevel + 1);
+    for(int level(minDrawnLevel); level <= maxDrawnLevel; ++level) {
+      GridOutlines(gpArray[level], cframe->gridSegments[level - minDrawnLevel]);
     }
-    XEvent event;
-    if(XCheckMaskEvent(display, ButtonPressMask, &event)) {
-      if(event.xany.window == XtWindow(pltAppPtr->GetStopButtonWidget())) {
-        XPutBackEvent(display, &event);
-        cancelled = true;
-        iEnd = i;
-        break;
+  }
+  return cframe;
+}
+
+
+// ---------------------------------------------------------------------
+// ---- the index frame this picture would show for another plot file,
+// ---- made without drawing anything.  returns nullptr if the picture
+// ---- has overlays or the file is not on the same levels and domain.
+CachedFrame *AmrPicture::MakeFileFrame(amrex::DataServices *dsp) {
+  const AmrData &amrData = dataServicesPtr->AmrDataRef();
+  const AmrData &fileData = dsp->AmrDataRef();
+  int minDrawnLevel(pltAppStatePtr->MinDrawnLevel());
+  int maxDrawnLevel(pltAppStatePtr->MaxDrawnLevel());
+  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+  if(pltAppStatePtr->GetContourType() != Amrvis::RASTERONLY ||
+     bCartGridSmoothing || fileData.FinestLevel() != amrData.FinestLevel() ||
+     fileData.ProbDomain()[maxAllowableLevel] != amrData.ProbDomain()[maxAllowableLevel])
+  {
+    return nullptr;
+  }
+
+  const string currentDerived(pltAppStatePtr->CurrentDerived());
+  const string vfracDerived("vfrac");
+  bool bCartGrid(fileData.CartGrid());
+  Real vfeps(bCartGrid ? fileData.VfEps(maxDrawnLevel) : 0.0);
+  Real minUsing, maxUsing;
+  pltAppStatePtr->GetMinMax(minUsing, maxUsing);
+
+  FArrayBox fileFab(sliceBox[maxDrawnLevel], 1);
+  amrex::DataServices::Dispatch(amrex::DataServices::FillVarOneFab, dsp,
+			 (void *) &fileFab,
+			 (void *) (&(fileFab.box())),
+			 maxDrawnLevel,
+                         (void *) &currentDerived);
+  FArrayBox vfFileFab;
+  FArrayBox *vffp = NULL;
+  if(bCartGrid) {
+    vfFileFab.resize(sliceBox[maxDrawnLevel], 1);
+    amrex::DataServices::Dispatch(amrex::DataServices::FillVarOneFab, dsp,
+		           (void *) &vfFileFab,
+			   (void *) (&(vfFileFab.box())),
+			   maxDrawnLevel,
+			   (void *) &vfracDerived);
+    vffp = &vfFileFab;
+  }
+
+  Vector<unsigned char> frameImageData(dataSize[maxDrawnLevel]);
+  CreateImage(fileFab, frameImageData.dataPtr(),
+	      dataSizeH[maxDrawnLevel], dataSizeV[maxDrawnLevel],
+              minUsing, maxUsing, palPtr, vffp, vfeps);
+  CachedFrame *cframe = new CachedFrame;
+  cframe->SetIndexData(frameImageData.dataPtr(),
+                       dataSizeH[maxDrawnLevel], dataSizeV[maxDrawnLevel]);
+  cframe->scale = pltAppStatePtr->CurrentScale() *
+                  amrex::CRRBetweenLevels(maxDrawnLevel, maxAllowableLevel,
+                                          fileData.RefRatio());
+
+  if(pltAppStatePtr->GetShowingBoxes()) {
+    cframe->minBoxLevel = minDrawnLevel;
+    cframe->gridSegments.resize(maxDrawnLevel - minDrawnLevel + 1);
+    for(int level(minDrawnLevel); level <= maxDrawnLevel; ++level) {
+      const BoxArray &fileBA = fileData.boxArray(level);
+      Vector<int> fileGrids;
+      GridIndex::Intersecting(fileBA, sliceBox[level], fileGrids);
+      Vector<GridPicture> levelGrids(fileGrids.size());
+      for(int iGrid(0); iGrid < fileGrids.size(); ++iGrid) {
+        Box temp(fileBA[fileGrids[iGrid]]);
+	temp &= sliceBox[level];
+	Box sliceDataBox(temp);
+	temp.shift(Amrvis::XDIR, -subDomain[level].smallEnd(Amrvis::XDIR));
+#if (BL_SPACEDIM > 1)
+	temp.shift(Amrvis::YDIR, -subDomain[level].smallEnd(Amrvis::YDIR));
+#endif
+#if (BL_SPACEDIM == 3)
+	temp.shift(Amrvis::ZDIR, -subDomain[level].smallEnd(Amrvis::ZDIR));
+#endif
+        levelGrids[iGrid].GridPictureInit(level,
+		amrex::CRRBetweenLevels(level, maxAllowableLevel,
+		                        fileData.RefRatio()),
+		pltAppStatePtr->CurrentScale(), imageSizeH, imageSizeV,
+		temp, sliceDataBox, sliceDir);
       }
+      GridOutlines(levelGrids, cframe->gridSegments[level - minDrawnLevel]);
+    }
+  }
+  return cframe;
+}
+
+
+// ---------------------------------------------------------------------
+// ---- draw a cached frame in the picture window.  index frames are
+// ---- decoded and colored with the current palette here.
+void AmrPicture::PutCachedFrame(const CachedFrame &cframe) {
+  XRectangle area;
+  area.x = 0;
+  area.y = 0;
+  area.width  = imageSizeH;
+  area.height = imageSizeV;
+  PutCachedFrame(cframe, area);
+}
+
+
+// ---------------------------------------------------------------------
+void AmrPicture::PutCachedFrame(const CachedFrame &cframe, const XRectangle &area) {
+  if( ! cframe.IsIndexFrame()) {
+    gaPtr->PutImage(pictureWindow, xgc, cframe.ximage,
+                    area.x, area.y, area.x, area.y, area.width, area.height);
+    return;
+  }
+
+  if(frameXImage == nullptr) {
+    frameXImage = gaPtr->CreateImage(imageSizeH, imageSizeV);
+  }
+  double time0(ParallelDescriptor::second());
+  frameIndexData.resize(cframe.IndexBytes());
+  cframe.GetIndexData(frameIndexData.dataPtr());
+  FrameCache::TheFrameCache().AddDecodeTime(ParallelDescriptor::second() - time0);
+
+  FillScaledImage(frameXImage, cframe.scale, frameIndexData.dataPtr(),
+                  cframe.dataSizeH, cframe.dataSizeV,
+                  imageSizeH, imageSizeV, pltAppStatePtr->MaxDrawnLevel(), true);
+  gaPtr->PutImage(pictureWindow, xgc, frameXImage,
+                  area.x, area.y, area.x, area.y, area.width, area.height);
+
+  int maxDataLevel(pltAppStatePtr->MaxAllowableLevel());
+  for(int ilev(0); ilev < cframe.gridSegments.size(); ++ilev) {
+    int level(cframe.minBoxLevel + ilev);
+    if(ilev == 0) {
+      XSetForeground(display, xgc, palPtr->WhiteIndex());
+    } else {
+      XSetForeground(display, xgc,
+		palPtr->makePixel(palPtr->SafePaletteIndex(level, maxDataLevel)));
     }
+    const Vector<XSegment> &levelSegments = cframe.gridSegments[ilev];
+    if(levelSegments.size() > 0) {
+      XDrawSegments(display, pictureWindow, xgc,
+                    const_cast<XSegment *>(levelSegments.dataPtr()),
+                    levelSegments.size());
+    }
+  }
+}
+
+
+// ---------------------------------------------------------------------
+void AmrPicture::CreateFrames(Amrvis::AnimDirection direction) {
+  char buffer[Amrvis::BUFSIZE];
+  bool cancelled(false);
+  int islice(0);
+  int maxAllowableLevel(pltAppStatePtr->MaxAllowableLevel());
+
+  sprintf(buffer, "Creating frames..."); 
+  PrintMessage(buffer);
+  int start = subDomain[maxAllowableLevel].smallEnd(sliceDir);
+  int length = subDomain[maxAllowableLevel].length(sliceDir);
+  ReleaseFrames();
+  frameGrids.resize(length); 
+  long gridQueries(GridIndex::Queries()), gridsFound(GridIndex::GridsFound());
+  double gridTime(ParallelDescriptor::second());
+  for(int iRelSlice(0); iRelSlice < length; ++iRelSlice) {
+    MakeFrameGrids(iRelSlice);
+  }
+  gridTime = ParallelDescriptor::second() - gridTime;
+
+  FrameCache &frameCache = FrameCache::TheFrameCache();
+  Vector<int> frameSlice(FrameSweepOrder(slice - start, direction));
+  double readTime(0.0), buildTime(0.0);
+  int nBatches(0);
+  int iFrame(0);
+  while(iFrame < length && ! cancelled) {
+    int iLast(FrameBatchEnd(frameSlice, iFrame));
+    Vector<CachedFrame *> batchFrames;
+    MakeFrameBatch(frameSlice, iFrame, iLast, batchFrames, readTime, buildTime);
+    ++nBatches;
+
+    // ---- each frame is shown before the cache owns it, since inserting
+    // ---- a frame can evict the earlier frames of the batch
+    for(int i(iFrame); i <= iLast; ++i) {
+      islice = frameSlice[i];
+      ShowFrameImage(islice, *batchFrames[i - iFrame]);
+      frameCache.Insert(this, islice, batchFrames[i - iFrame]);
+      batchFrames[i - iFrame] = nullptr;
+#if (BL_SPACEDIM == 3)
+    
+      if( ! framesMade) {
+        pltAppPtr->GetProjPicturePtr()->ChangeSlice(Amrvis::YZ-sliceDir, islice+start);
+        pltAppPtr->GetProjPicturePtr()->MakeSlices();
+        XClearWindow(XtDisplay(pltAppPtr->GetWTransDA()),
+                     XtWindow(pltAppPtr->GetWTransDA()));
+        pltAppPtr->DoExposeTransDA();
+      }
+      XEvent event;
+      if(XCheckMaskEvent(display, ButtonPressMask, &event)) {
+        if(event.xany.window == XtWindow(pltAppPtr->GetStopButtonWidget())) {
+          XPutBackEvent(display, &event);
+          cancelled = true;
+          break;
+        }
+      }
 #endif
-  }  // end for(i=0; ...)
+    }
+    for(int i(0); i < batchFrames.size(); ++i) {  // ---- not shown if cancelled
+      delete batchFrames[i];
+    }
+    iFrame = iLast + 1;
+  }  // end while(iFrame...)
 
-  delete [] frameImageData;
+  if(AVGlobals::Verbose()) {
+    cout << "_in CreateFrames:  " << length << " frames from " << nBatches
+         << " slab reads:  read time = " << readTime
+         << " s, build time = " << buildTime << " s" << endl;
+    cout << "_in CreateFrames:  frame grids made in " << gridTime << " s" << endl;
+    GridIndex::PrintStats(cout, gridQueries, gridsFound, length);
+    frameCache.PrintStats(cout);
+    gaPtr->PrintImageStats(cout);
+  }
 
   if(cancelled) {
-    for(int iiss(0); iiss <= iEnd; ++iiss) {
-      int iDestroySlice((((slice - start + (posneg * iiss)) + length) % length));
-      XDestroyImage(frameBuffer[iDestroySlice]);
-    }
-    framesMade = false;
+    ReleaseFrames();
     sprintf(buffer, "Cancelled.\n"); 
     PrintMessage(buffer);
     APChangeSlice(start+islice);
@@ -1810,7 +2209,7 @@ void AmrPicture::DoFrameUpdate() {
   } 
   BL_ASSERT(DrawContours(pltAppStatePtr->GetContourType()) == false);
   int iRelSlice(slice - subDomain[maxAllowableLevel].smallEnd(sliceDir));
-  ShowFrameImage(iRelSlice);
+  ShowFrameImage(iRelSlice, *GetFrame(iRelSlice));
   XSync(display, false);
   pendingTimeOut = XtAppAddTimeOut(pltAppPtr->GetAppContext(), frameSpeed,
 			   (XtTimerCallbackProc) &AmrPicture::CBFrameTimeOut,
@@ -1836,6 +2235,10 @@ void AmrPicture::DoStop() {
   if(pendingTimeOut != 0) {
     XtRemoveTimeOut(pendingTimeOut);
     pendingTimeOut = 0;
+    if(AVGlobals::Verbose()) {
+      FrameCache::TheFrameCache().PrintStats(cout);
+      gaPtr->PrintImageStats(cout);
+    }
     APChangeSlice(slice);
   }
 }
@@ -1873,14 +2276,13 @@ void AmrPicture::DrawSlice(int /*iSlice*/) {
 
 
 // ---------------------------------------------------------------------
-void AmrPicture::ShowFrameImage(int iSlice) {
+void AmrPicture::ShowFrameImage(int iSlice, const CachedFrame &cframe) {
   AmrPicture *apXY = pltAppPtr->GetAmrPicturePtr(Amrvis::XY);
   AmrPicture *apXZ = pltAppPtr->GetAmrPicturePtr(Amrvis::XZ);
   AmrPicture *apYZ = pltAppPtr->GetAmrPicturePtr(Amrvis::YZ);
   int iRelSlice(iSlice);
 
-  XPutImage(display, pictureWindow, xgc,
-            frameBuffer[iRelSlice], 0, 0, 0, 0, imageSizeH, imageSizeV);
+  PutCachedFrame(cframe);
 
   DrawBoxes(frameGrids[iRelSlice], pictureWindow);
 
@@ -1985,13 +2387,16 @@ void AmrPicture::DrawContour(Vector<FArrayBox *> passedSliceFab,
     if(lev != maxDrawnLevel) {
       int lratio(amrex::CRRBetweenLevels(lev, lev + 1, amrData.RefRatio()));
       // construct mask array.  must be size FAB.
+      // ---- only the finer grids over the slice can cover it
       const BoxArray &nextFinest = amrData.boxArray(lev+1);
-      for(int j(0); j < nextFinest.size(); ++j) {
-        Box coarseBox(amrex::coarsen(nextFinest[j],lratio));
-        if(coarseBox.intersects(passedSliceFab[lev]->box())) {
-          coarseBox &= passedSliceFab[lev]->box();
-          mask.setVal(true,coarseBox,0);
-        }
+      Vector<int> coveringGrids;
+      GridIndex::Intersecting(nextFinest,
+                              amrex::refine(passedSliceFab[lev]->box(), lratio),
+                              coveringGrids);
+      for(int j(0); j < coveringGrids.size(); ++j) {
+        Box coarseBox(amrex::coarsen(nextFinest[coveringGrids[j]],lratio));
+        coarseBox &= passedSliceFab[lev]->box();
+        mask.setVal(true,coarseBox,0);
       }
     }
     
@@ -0,0 +1,440 @@
+// ---------------------------------------------------------------
+// AmrRayCaster.cpp
+// ---------------------------------------------------------------
+#include <AmrRayCaster.H>
+#include <GlobalUtilities.H>
+#include <GridIndex.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_FArrayBox.H>
+#include <AMReX_AmrvisConstants.H>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+using std::cout;
+using std::endl;
+
+using namespace amrex;
+
+namespace {
+  const int rayTileSize(32);
+}
+
+
+// -------------------------------------------------------------------
+AmrRayCaster::AmrRayCaster(const Vector<Box> &drawdomain, int mindrawnlevel,
+                           int maxdrawnlevel, int finestlevel)
+  : drawnDomain(drawdomain),
+    minDrawnLevel(mindrawnlevel),
+    maxDrawnLevel(maxdrawnlevel),
+    finestLevel(finestlevel),
+    dataServicesPtr(nullptr),
+    dataMin(0.0),
+    dataMax(0.0),
+    dataPaletteStart(0),
+    dataColorSlots(0)
+{
+  rayShading.bLighting = true;
+  rayShading.ambient  = 0.28;
+  rayShading.diffuse  = 0.35;
+  rayShading.specular = 0.39;
+  rayShading.shiny    = 10.0;
+  rayShading.minRayOpacity = 0.05;
+  rayShading.maxRayOpacity = 0.95;
+}
+
+
+// -------------------------------------------------------------------
+bool AmrRayCaster::DataMatches(DataServices *dsp, Real rDataMin, Real rDataMax,
+                               const string &derivedName, int iPaletteStart,
+                               int iColorSlots) const
+{
+  return (dataServicesPtr != nullptr && dsp == dataServicesPtr &&
+          rDataMin == dataMin && rDataMax == dataMax &&
+          derivedName == dataDerived && iPaletteStart == dataPaletteStart &&
+          iColorSlots == dataColorSlots);
+}
+
+
+// -------------------------------------------------------------------
+void AmrRayCaster::MakeGridData(DataServices *dsp, Real rDataMin, Real rDataMax,
+                                const string &derivedName, int iPaletteStart,
+                                int iColorSlots)
+{
+  double time0(ParallelDescriptor::second());
+  const AmrData &amrData = dsp->AmrDataRef();
+
+  Real globalDiff(rDataMax - rDataMin);
+  Real oneOverGDiff;
+  if(globalDiff < FLT_MIN) {
+    oneOverGDiff = 0.0;  // so we dont divide by zero
+  } else {
+    oneOverGDiff = 1.0 / globalDiff;
+  }
+  int cSlotsAvail(iColorSlots - 1);
+
+  long nCells(0);
+  rayGrids.clear();
+  for(int lev(minDrawnLevel); lev <= maxDrawnLevel; ++lev) {
+    int crr(amrex::CRRBetweenLevels(lev, finestLevel, amrData.RefRatio()));
+    const BoxArray &gridBoxes = amrData.boxArray(lev);
+    Vector<int> drawnGrids;
+    GridIndex::Intersecting(gridBoxes, drawnDomain[lev], drawnGrids);
+    for(int iGrid(0); iGrid < drawnGrids.size(); ++iGrid) {
+      rayGrids.push_back(RayGrid());
+      RayGrid &rayGrid = rayGrids.back();
+      rayGrid.box   = gridBoxes[drawnGrids[iGrid]] & drawnDomain[lev];
+      rayGrid.level = lev;
+      rayGrid.crr   = crr;
+      for(int dir(0); dir < 3; ++dir) {
+        rayGrid.lo[dir] = static_cast<Real>(rayGrid.box.smallEnd(dir) * crr);
+        rayGrid.hi[dir] = static_cast<Real>((rayGrid.box.bigEnd(dir) + 1) * crr);
+      }
+
+      FArrayBox gridFab(rayGrid.box, 1);
+      DataServices::Dispatch(DataServices::FillVarOneFab, dsp,
+                             (void *) &gridFab,
+                             (void *) &rayGrid.box,
+                             lev,
+                             (void *) &derivedName);
+
+      long nPts(rayGrid.box.numPts());
+      const Real *dataPoint = gridFab.dataPtr();
+      rayGrid.data.resize(nPts);
+      unsigned char *gridData = rayGrid.data.dataPtr();
+      int minIndex(255), maxIndex(0);
+#ifdef _OPENMP
+#pragma omp parallel for reduction(min:minIndex) reduction(max:maxIndex) if(nPts > 65536)
+#endif
+      for(long i = 0; i < nPts; ++i) {
+        Real dat(std::min(std::max(dataPoint[i], rDataMin), rDataMax));
+        unsigned char index((char) (((dat - rDataMin) * oneOverGDiff) * cSlotsAvail)
+                            + (char) iPaletteStart);
+        gridData[i] = index;
+        minIndex = std::min(minIndex, static_cast<int>(index));
+        maxIndex = std::max(maxIndex, static_cast<int>(index));
+      }
+      rayGrid.minIndex = minIndex;
+      rayGrid.maxIndex = maxIndex;
+      nCells += nPts;
+    }
+  }
+
+  dataServicesPtr  = dsp;
+  dataMin          = rDataMin;
+  dataMax          = rDataMax;
+  dataDerived      = derivedName;
+  dataPaletteStart = iPaletteStart;
+  dataColorSlots   = iColorSlots;
+
+  if(AVGlobals::Verbose()) {
+    cout << "_in AmrRayCaster::MakeGridData:  " << rayGrids.size() << " grids, "
+         << nCells << " cells, time = "
+         << ParallelDescriptor::second() - time0 << endl;
+  }
+}
+
+
+// -------------------------------------------------------------------
+void AmrRayCaster::Render(unsigned char *image, int width, int height,
+                          int pixelscale, const RayView &view) const
+{
+  double time0(ParallelDescriptor::second());
+  std::fill(image, image + static_cast<long>(width) * height, 0);
+  if(rayGrids.empty() || view.scale <= 0.0 || width <= 0 || height <= 0) {
+    return;
+  }
+
+  // ---- the third row points toward the viewer
+  Real eyeRot[3][3];
+  for(int dir(0); dir < 3; ++dir) {
+    eyeRot[0][dir] = view.rot[0][dir];
+    eyeRot[1][dir] = view.rot[1][dir];
+  }
+  eyeRot[2][0] = view.rot[0][1] * view.rot[1][2] - view.rot[0][2] * view.rot[1][1];
+  eyeRot[2][1] = view.rot[0][2] * view.rot[1][0] - view.rot[0][0] * view.rot[1][2];
+  eyeRot[2][2] = view.rot[0][0] * view.rot[1][1] - view.rot[0][1] * view.rot[1][0];
+
+  // ---- rays start on a plane in front of all the grids
+  Real gLo[3], gHi[3];
+  for(int dir(0); dir < 3; ++dir) {
+    gLo[dir] = rayGrids[0].lo[dir];
+    gHi[dir] = rayGrids[0].hi[dir];
+  }
+  for(int iGrid(1); iGrid < rayGrids.size(); ++iGrid) {
+    for(int dir(0); dir < 3; ++dir) {
+      gLo[dir] = std::min(gLo[dir], rayGrids[iGrid].lo[dir]);
+      gHi[dir] = std::max(gHi[dir], rayGrids[iGrid].hi[dir]);
+    }
+  }
+  Real reach(0.0);
+  for(int dir(0); dir < 3; ++dir) {
+    Real extent(std::max(std::fabs(gLo[dir] - view.center[dir]),
+                         std::fabs(gHi[dir] - view.center[dir])));
+    reach += extent * extent;
+  }
+  reach = std::sqrt(reach) + 1.0;
+
+  // ---- grids with only transparent indices are skipped
+  Vector<char> gridIsEmpty(rayGrids.size(), 0);
+  for(int iGrid(0); iGrid < rayGrids.size(); ++iGrid) {
+    Real maxOpacity(0.0);
+    for(int idx(rayGrids[iGrid].minIndex); idx <= rayGrids[iGrid].maxIndex; ++idx) {
+      if(idx < transfer.size()) {
+        maxOpacity = std::max(maxOpacity, static_cast<Real>(transfer[idx]));
+      }
+    }
+    gridIsEmpty[iGrid] = (maxOpacity < rayShading.minRayOpacity);
+  }
+
+  // ---- bin the grids into tiles by their screen bounding boxes
+  int nTilesX((width  + rayTileSize - 1) / rayTileSize);
+  int nTilesY((height + rayTileSize - 1) / rayTileSize);
+  Vector< Vector<int> > tileGrids(nTilesX * nTilesY);
+  for(int iGrid(0); iGrid < rayGrids.size(); ++iGrid) {
+    const RayGrid &rayGrid = rayGrids[iGrid];
+    Real xMin(FLT_MAX), xMax(-FLT_MAX), yMin(FLT_MAX), yMax(-FLT_MAX);
+    for(int iv(0); iv < 8; ++iv) {
+      Real corner[3] = { ((iv & 1) ? rayGrid.hi[0] : rayGrid.lo[0]) - view.center[0],
+                         ((iv & 2) ? rayGrid.hi[1] : rayGrid.lo[1]) - view.center[1],
+                         ((iv & 4) ? rayGrid.hi[2] : rayGrid.lo[2]) - view.center[2] };
+      Real sx(view.offset[0]), sy(view.offset[1]);
+      for(int dir(0); dir < 3; ++dir) {
+        sx += corner[dir] * view.rot[0][dir] * view.scale;
+        sy += corner[dir] * view.rot[1][dir] * view.scale;
+      }
+      sy = view.height - sy;
+      xMin = std::min(xMin, sx);  xMax = std::max(xMax, sx);
+      yMin = std::min(yMin, sy);  yMax = std::max(yMax, sy);
+    }
+    int txLo(std::max(0, static_cast<int>(std::floor(xMin / pixelscale)) - 1) / rayTileSize);
+    int txHi(std::min(width - 1, static_cast<int>(std::floor(xMax / pixelscale)) + 1) / rayTileSize);
+    int tyLo(std::max(0, static_cast<int>(std::floor(yMin / pixelscale)) - 1) / rayTileSize);
+    int tyHi(std::min(height - 1, static_cast<int>(std::floor(yMax / pixelscale)) + 1) / rayTileSize);
+    for(int ty(tyLo); ty <= tyHi; ++ty) {
+      for(int tx(txLo); tx <= txHi; ++tx) {
+        tileGrids[ty * nTilesX + tx].push_back(iGrid);
+      }
+    }
+  }
+
+  // ---- the threads take tiles as they finish them, so tiles with
+  // ---- many grids or long rays do not hold up the others
+  int nTiles(nTilesX * nTilesY);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    Vector<RaySpan> spans;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for(int iTile = 0; iTile < nTiles; ++iTile) {
+      if(tileGrids[iTile].empty()) {
+        continue;
+      }
+      int iLo((iTile % nTilesX) * rayTileSize), iHi(std::min(iLo + rayTileSize, width));
+      int jLo((iTile / nTilesX) * rayTileSize), jHi(std::min(jLo + rayTileSize, height));
+      for(int j(jLo); j < jHi; ++j) {
+        Real b((view.height - (j + 0.5) * pixelscale - view.offset[1]) / view.scale);
+        for(int i(iLo); i < iHi; ++i) {
+          Real a(((i + 0.5) * pixelscale - view.offset[0]) / view.scale);
+          Real origin[3], dir[3];
+          for(int d(0); d < 3; ++d) {
+            origin[d] = view.center[d] + a * eyeRot[0][d] + b * eyeRot[1][d] +
+                        reach * eyeRot[2][d];
+            dir[d] = -eyeRot[2][d];
+          }
+          Real luminance(CastRay(origin, dir, 2.0 * reach, tileGrids[iTile],
+                                 gridIsEmpty, eyeRot, spans));
+          image[static_cast<long>(j) * width + i] =
+                 static_cast<unsigned char>(std::min(255, static_cast<int>(luminance + 0.5)));
+        }
+      }
+    }
+  }
+
+  if(AVGlobals::Verbose()) {
+    cout << "_in AmrRayCaster::Render:  " << width << "x" << height << ", "
+         << nTiles << " tiles, time = "
+         << ParallelDescriptor::second() - time0 << endl;
+  }
+}
+
+
+// -------------------------------------------------------------------
+// ---- composite front to back along origin + s * dir, s in [0, sMax].
+// ---- at each s the ray samples the finest grid it is in.
+Real AmrRayCaster::CastRay(const Real origin[3], const Real dir[3], Real sMax,
+                           const Vector<int> &tileGrids,
+                           const Vector<char> &gridIsEmpty,
+                           const Real eyeRot[3][3],
+                           Vector<RaySpan> &spans) const
+{
+  spans.clear();
+  for(int ig(0); ig < tileGrids.size(); ++ig) {
+    const RayGrid &rayGrid = rayGrids[tileGrids[ig]];
+    Real sEnter(0.0), sExit(sMax);
+    bool bMiss(false);
+    for(int d(0); d < 3 && ! bMiss; ++d) {
+      if(std::fabs(dir[d]) < 1.0e-12) {
+        bMiss = (origin[d] < rayGrid.lo[d] || origin[d] >= rayGrid.hi[d]);
+      } else {
+        Real s0((rayGrid.lo[d] - origin[d]) / dir[d]);
+        Real s1((rayGrid.hi[d] - origin[d]) / dir[d]);
+        sEnter = std::max(sEnter, std::min(s0, s1));
+        sExit  = std::min(sExit,  std::max(s0, s1));
+        bMiss = (sEnter >= sExit);
+      }
+    }
+    if( ! bMiss) {
+      RaySpan span;
+      span.sEnter = sEnter;
+      span.sExit  = sExit;
+      span.iGrid  = tileGrids[ig];
+      spans.push_back(span);
+    }
+  }
+  if(spans.empty()) {
+    return 0.0;
+  }
+  std::sort(spans.begin(), spans.end(),
+            [] (const RaySpan &lhs, const RaySpan &rhs) { return lhs.sEnter < rhs.sEnter; });
+
+  Real luminance(0.0), alpha(0.0);
+  Real s(spans[0].sEnter);
+  int nSpans(spans.size()), iFirst(0);
+  while(alpha < rayShading.maxRayOpacity) {
+    while(iFirst < nSpans && spans[iFirst].sExit <= s) {
+      ++iFirst;
+    }
+    // ---- the finest grid at s, and where the next grid starts
+    int iCover(-1);
+    Real sNext(sMax);
+    for(int k(iFirst); k < nSpans; ++k) {
+      if(spans[k].sEnter > s) {
+        sNext = spans[k].sEnter;
+        break;
+      }
+      if(s < spans[k].sExit && (iCover < 0 ||
+         rayGrids[spans[k].iGrid].level > rayGrids[spans[iCover].iGrid].level))
+      {
+        iCover = k;
+      }
+    }
+    if(iCover < 0) {
+      if(sNext >= sMax) {
+        break;
+      }
+      s = sNext;
+      continue;
+    }
+
+    const RaySpan &cover = spans[iCover];
+    const RayGrid &rayGrid = rayGrids[cover.iGrid];
+    if(gridIsEmpty[cover.iGrid]) {
+      // ---- jump to the end of the grid or to a finer grid inside it
+      Real sSkip(cover.sExit);
+      for(int k(iCover + 1); k < nSpans && spans[k].sEnter < sSkip; ++k) {
+        if(spans[k].sEnter > s && rayGrids[spans[k].iGrid].level > rayGrid.level) {
+          sSkip = spans[k].sEnter;
+        }
+      }
+      s = sSkip;
+      continue;
+    }
+
+    // ---- one step is one cell of the grid level, cut short at the
+    // ---- end of the grid or where a finer grid starts, so no part
+    // ---- of the ray is composited twice
+    Real sStepEnd(std::min(s + rayGrid.crr, cover.sExit));
+    for(int k(iCover + 1); k < nSpans && spans[k].sEnter < sStepEnd; ++k) {
+      if(spans[k].sEnter > s && rayGrids[spans[k].iGrid].level > rayGrid.level) {
+        sStepEnd = spans[k].sEnter;
+      }
+    }
+    Real ds(sStepEnd - s);
+    Real sSample(s + 0.5 * ds);
+    int cell[3];
+    for(int d(0); d < 3; ++d) {
+      Real p(origin[d] + sSample * dir[d]);
+      cell[d] = static_cast<int>(std::floor(p / rayGrid.crr));
+      cell[d] = std::max(rayGrid.box.smallEnd(d), std::min(rayGrid.box.bigEnd(d), cell[d]));
+    }
+    const IntVect &boxLo = rayGrid.box.smallEnd();
+    long idx((cell[0] - boxLo[0]) + rayGrid.box.length(0) *
+             ((cell[1] - boxLo[1]) + static_cast<long>(rayGrid.box.length(1)) *
+              (cell[2] - boxLo[2])));
+    unsigned char index(rayGrid.data[idx]);
+    Real opacity(index < transfer.size() ? transfer[index] : 0.0);
+    if(opacity >= rayShading.minRayOpacity) {
+      // ---- opacity is for one finest level cell, so a step of ds
+      // ---- finest cells is as opaque as the ds cells it crosses
+      Real stepAlpha(ds == 1.0 ? opacity : 1.0 - std::pow(1.0 - opacity, ds));
+      Real shade;
+      if(rayShading.bLighting) {
+        shade = Shade(rayGrid, cell[0], cell[1], cell[2], eyeRot);
+      } else {  // ---- the value model shades with the index, as VolRender does
+        shade = (index == 0 ? AVGlobals::MaxPaletteIndex() : index);
+      }
+      luminance += (1.0 - alpha) * stepAlpha * shade;
+      alpha     += (1.0 - alpha) * stepAlpha;
+    }
+    s = sStepEnd;
+    if(s >= sMax) {
+      break;
+    }
+  }
+  return luminance;
+}
+
+
+// -------------------------------------------------------------------
+// ---- the lighting model for one cell, with the normal from the index
+// ---- gradient and the light VolRender uses
+Real AmrRayCaster::Shade(const RayGrid &rayGrid, int i, int j, int k,
+                         const Real eyeRot[3][3]) const
+{
+  const Box &box = rayGrid.box;
+  const IntVect &boxLo = box.smallEnd();
+  int len0(box.length(0)), len1(box.length(1));
+  int cell[3] = { i - boxLo[0], j - boxLo[1], k - boxLo[2] };
+  Real grad[3];
+  for(int d(0); d < 3; ++d) {
+    int cm[3] = { cell[0], cell[1], cell[2] };
+    int cp[3] = { cell[0], cell[1], cell[2] };
+    cm[d] = std::max(cell[d] - 1, 0);
+    cp[d] = std::min(cell[d] + 1, box.length(d) - 1);
+    if(cp[d] == cm[d]) {
+      grad[d] = 0.0;
+      continue;
+    }
+    long im(cm[0] + len0 * (cm[1] + static_cast<long>(len1) * cm[2]));
+    long ip(cp[0] + len0 * (cp[1] + static_cast<long>(len1) * cp[2]));
+    grad[d] = (static_cast<Real>(rayGrid.data[ip]) - rayGrid.data[im]) / (cp[d] - cm[d]);
+  }
+  Real gMag(std::sqrt(grad[0] * grad[0] + grad[1] * grad[1] + grad[2] * grad[2]));
+  if(gMag <= 0.0) {
+    return 255.0 * std::min(static_cast<Real>(1.0), rayShading.ambient);
+  }
+  Real normal[3];
+  for(int r(0); r < 3; ++r) {
+    normal[r] = (eyeRot[r][0] * grad[0] + eyeRot[r][1] * grad[1] +
+                 eyeRot[r][2] * grad[2]) / gMag;
+  }
+
+  // ---- light direction (0.3, 0.3, 1.0) and the halfway vector to the viewer
+  const Real lightLen(std::sqrt(0.3 * 0.3 + 0.3 * 0.3 + 1.0));
+  const Real light[3] = { 0.3 / lightLen, 0.3 / lightLen, 1.0 / lightLen };
+  Real half[3] = { light[0], light[1], light[2] + 1.0 };
+  Real halfLen(std::sqrt(half[0] * half[0] + half[1] * half[1] + half[2] * half[2]));
+  Real nDotL(std::fabs(normal[0] * light[0] + normal[1] * light[1] + normal[2] * light[2]));
+  Real nDotH(std::fabs(normal[0] * half[0] + normal[1] * half[1] + normal[2] * half[2]) /
+             halfLen);
+  Real shade(rayShading.ambient + rayShading.diffuse * nDotL +
+             rayShading.specular * std::pow(nDotH, rayShading.shiny));
+  return 255.0 * std::min(static_cast<Real>(1.0), shade);
+}
+// ---------------------------------------------------------------
+// ---------------------------------------------------------------
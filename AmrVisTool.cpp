@@ -6,6 +6,7 @@
 #include <AMReX_BLProfiler.H>
 
 #include <stdio.h>
+#include <unistd.h>
 #if ! (defined(BL_OSF1) || defined(BL_Darwin) || defined(BL_AIX) || defined(BL_IRIX64) || defined(BL_CYGWIN_NT) || defined(BL_CRAYX1))
 #include <endian.h>
 #endif
@@ -164,17 +165,31 @@ int main(int argc, char *argv[]) {
       bool bAmrDataOk(true);
       amrex::Amrvis::FileType fileType = AVGlobals::GetDefaultFileType();
       BL_ASSERT(fileType != amrex::Amrvis::INVALIDTYPE);
-      amrex::Vector<amrex::DataServices *> dspArray(AVGlobals::GetFileCount());
-      for(int nPlots = 0; nPlots < AVGlobals::GetFileCount(); ++nPlots) {
-        comlineFileName = AVGlobals::GetComlineFilename(nPlots);
-        dspArray[nPlots] = new amrex::DataServices(comlineFileName, fileType);
-        if(amrex::ParallelDescriptor::IOProcessor()) {
-          dspArray[nPlots]->IncrementNumberOfUsers();
-	}
-	if( ! dspArray[nPlots]->AmrDataOk()) {
+      // ---- only the first file is read here, the PltApp opens
+      // ---- the others as they are needed.  the rest are checked
+      // ---- for existence only.
+      double dStartTime(amrex::ParallelDescriptor::second());
+      amrex::Vector<amrex::DataServices *> dspArray(AVGlobals::GetFileCount(), nullptr);
+      comlineFileName = AVGlobals::GetComlineFilename(0);
+      dspArray[0] = new amrex::DataServices(comlineFileName, fileType);
+      if(amrex::ParallelDescriptor::IOProcessor()) {
+        dspArray[0]->IncrementNumberOfUsers();
+      }
+      if( ! dspArray[0]->AmrDataOk()) {
+        bAmrDataOk = false;
+      }
+      for(int nPlots = 1; nPlots < AVGlobals::GetFileCount(); ++nPlots) {
+        if(access(AVGlobals::GetComlineFilename(nPlots).c_str(), R_OK) != 0) {
+          cerr << "Error:  cannot read file " << AVGlobals::GetComlineFilename(nPlots)
+               << endl;
 	  bAmrDataOk = false;
 	}
       }
+      if(AVGlobals::Verbose() && amrex::ParallelDescriptor::IOProcessor()) {
+        cout << "_in main:  opened 1 of " << AVGlobals::GetFileCount()
+             << " animation files in "
+             << amrex::ParallelDescriptor::second() - dStartTime << " s" << endl;
+      }
 
       if(amrex::ParallelDescriptor::IOProcessor()) {
 	if(bAmrDataOk) {
@@ -183,11 +198,13 @@ int main(int argc, char *argv[]) {
 			            dspArray, AVGlobals::IsAnimation());
 	  if(temp == NULL) {
 	    cerr << "Error:  could not make a new PltApp." << endl;
-            for(int nPlots = 0; nPlots < AVGlobals::GetFileCount(); ++nPlots) {
-              dspArray[nPlots]->DecrementNumberOfUsers();
-	    }
+            dspArray[0]->DecrementNumberOfUsers();
 	  } else {
             pltAppList.push_back(temp);
+            if(AVGlobals::Verbose()) {
+              cout << "_in main:  animation window ready in "
+                   << amrex::ParallelDescriptor::second() - dStartTime << " s" << endl;
+            }
               if(AVGlobals::GivenBox()) {
 		amrex::DataServices *dsp = temp->GetDataServicesPtr();
 	        const amrex::AmrData &amrData = dsp->AmrDataRef();
@@ -210,9 +227,7 @@ int main(int argc, char *argv[]) {
 	  }
 	} else {
           if(amrex::ParallelDescriptor::IOProcessor()) {
-            for(int nPlots = 0; nPlots < AVGlobals::GetFileCount(); ++nPlots) {
-              dspArray[nPlots]->DecrementNumberOfUsers();
-	    }
+            dspArray[0]->DecrementNumberOfUsers();
 	  }
 	}
       }
@@ -568,7 +583,9 @@ void QuitAll() {
     PltApp *obj = *li;
     amrex::Vector<amrex::DataServices *> dataServicesPtr = obj->GetDataServicesPtrArray();
     for(int ids(0); ids < dataServicesPtr.size(); ++ids) {
-      dataServicesPtr[ids]->DecrementNumberOfUsers();
+      if(dataServicesPtr[ids] != nullptr) {  // ---- unopened animation file
+        dataServicesPtr[ids]->DecrementNumberOfUsers();
+      }
     }
     delete obj;
   }
@@ -687,11 +704,8 @@ void SubregionPltApp(Widget swTopLevel, const amrex::Box &trueRegion,
   if(temp == NULL) {
     cerr << "Error in SubregionPltApp:  could not make a new PltApp." << endl;
   } else {
+    // ---- the new PltApp adds itself as a user of its parent's open files
     pltAppList.push_back(temp);
-    amrex::Vector<amrex::DataServices *> dataServicesPtr = temp->GetDataServicesPtrArray();
-    for(int ids(0); ids < dataServicesPtr.size(); ++ids) {
-      dataServicesPtr[ids]->IncrementNumberOfUsers();
-    }
   }
 }
 
@@ -726,6 +740,9 @@ void CBQuitPltApp(Widget /*ofPltApp*/, XtPointer client_data, XtPointer) {
 
   amrex::Vector<amrex::DataServices *> &dataServicesPtr = obj->GetDataServicesPtrArray();
   for(int ids(0); ids < dataServicesPtr.size(); ++ids) {
+    if(dataServicesPtr[ids] == nullptr) {  // ---- unopened animation file
+      continue;
+    }
     dataServicesPtr[ids]->DecrementNumberOfUsers();
     amrex::DataServices::Dispatch(amrex::DataServices::DeleteRequest, dataServicesPtr[ids], NULL);
   }
@@ -26,11 +26,21 @@ const int MAXINDEXCHARS   = 4;
 #include <PltApp.H>
 #include <PltAppState.H>
 #include <AmrPicture.H>
+#include <RangeIndex.H>
+#include <GridIndex.H>
 #include <AMReX_DataServices.H>
 
 #include <sstream>
 #include <cfloat>
 #include <cmath>
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
 using std::ostringstream;
 using std::cout;
 using std::cerr;
@@ -38,6 +48,131 @@ using std::endl;
 
 using namespace amrex;
 
+namespace {
+
+// -------------------------------------------------------------------
+// ---- a printf format for one value, such as "%7.5e".  plain %e, %f
+// ---- and %g formats, with an optional '-', width and precision, are
+// ---- written with std::to_chars where the library has the floating
+// ---- point overloads, which gives the same digits without parsing
+// ---- the format for each value.  other formats use snprintf.
+class CellFormat {
+  public:
+    explicit CellFormat(const string &fstring);
+    // ---- write value into buf, returns the length
+    int Format(Real value, char *buf, int bufsize) const;
+
+  private:
+    string formatString;
+    bool bToChars, bLeftJustify;
+    int  fieldWidth, precision;
+#ifdef __cpp_lib_to_chars
+    std::chars_format charsFormat;
+#endif
+};
+
+
+// -------------------------------------------------------------------
+CellFormat::CellFormat(const string &fstring)
+  : formatString(fstring),
+    bToChars(false),
+    bLeftJustify(false),
+    fieldWidth(0),
+    precision(6)
+{
+#ifdef __cpp_lib_to_chars
+  const char *fc(fstring.c_str());
+  if(*fc++ != '%') {
+    return;
+  }
+  if(*fc == '-') {
+    bLeftJustify = true;
+    ++fc;
+  }
+  if(*fc == '+' || *fc == ' ' || *fc == '#' || *fc == '0') {  // ---- other flags
+    return;
+  }
+  while(isdigit(*fc)) {
+    fieldWidth = fieldWidth * 10 + (*fc++ - '0');
+  }
+  if(*fc == '.') {
+    ++fc;
+    precision = 0;
+    while(isdigit(*fc)) {
+      precision = precision * 10 + (*fc++ - '0');
+    }
+  }
+  if(*fc == 'l') {
+    ++fc;
+  }
+  if(fc[0] == '\0' || fc[1] != '\0') {
+    return;
+  }
+  if(fc[0] == 'e') {
+    charsFormat = std::chars_format::scientific;
+    bToChars = true;
+  } else if(fc[0] == 'f') {
+    charsFormat = std::chars_format::fixed;
+    bToChars = true;
+  } else if(fc[0] == 'g') {
+    charsFormat = std::chars_format::general;
+    bToChars = true;
+  }
+#endif
+}
+
+
+// -------------------------------------------------------------------
+int CellFormat::Format(Real value, char *buf, int bufsize) const {
+#ifdef __cpp_lib_to_chars
+  if(bToChars && fieldWidth < bufsize) {
+    std::to_chars_result result(std::to_chars(buf, buf + bufsize - 1, value,
+                                              charsFormat, precision));
+    if(result.ec == std::errc()) {
+      int len(result.ptr - buf);
+      if(len < fieldWidth) {  // ---- pad as printf does
+        if(bLeftJustify) {
+          std::fill(buf + len, buf + fieldWidth, ' ');
+        } else {
+          std::memmove(buf + fieldWidth - len, buf, len);
+          std::fill(buf, buf + fieldWidth - len, ' ');
+        }
+        len = fieldWidth;
+      }
+      buf[len] = '\0';
+      return len;
+    }
+  }
+#endif
+  snprintf(buf, bufsize, formatString.c_str(), value);
+  return strlen(buf);
+}
+
+
+// -------------------------------------------------------------------
+// ---- the widest string expected for values in [rmin, rmax]:  the
+// ---- ends, full mantissas at the ends' magnitudes, and a small value
+// ---- if the range reaches zero, which %g writes with an exponent
+int EstimateWidth(const CellFormat &cellformat, Real rmin, Real rmax) {
+  Vector<Real> probes;
+  probes.push_back(rmin);
+  probes.push_back(rmax);
+  probes.push_back(rmin / 3.0);
+  probes.push_back(rmax / 3.0);
+  if(rmin < 1.0e-04 && rmax > -1.0e-04) {
+    probes.push_back((rmin < 0.0 ? -1.0 : 1.0) / 3.0e+05);
+  }
+  char probeString[MAXSTRINGWIDTH];
+  int width(0);
+  for(int i(0); i < probes.size(); ++i) {
+    width = std::max(width, cellformat.Format(probes[i], probeString,
+                                              MAXSTRINGWIDTH));
+  }
+  return width;
+}
+
+}  // end namespace
+
 // -------------------------------------------------------------------
 Dataset::Dataset(const Box &alignedRegion, AmrPicture *apptr,
 		 PltApp *pltappptr, PltAppState *pltappstateptr,
@@ -241,9 +376,8 @@ Dataset::Dataset(const Box &alignedRegion, AmrPicture *apptr,
 
   dragging = false;
   drags = 0;
+  exposeDamage = nullptr;
 
-  myDataStringArray = NULL;
-  bDataStringArrayAllocated = false;
 
   DatasetRender(alignedRegion, amrPicturePtr, pltAppPtr, pltAppStatePtr,
 		hdir, vdir, sdir);
@@ -252,16 +386,12 @@ Dataset::Dataset(const Box &alignedRegion, AmrPicture *apptr,
 
 // -------------------------------------------------------------------
 Dataset::~Dataset() {
+  if(exposeDamage != nullptr) {
+    XDestroyRegion(exposeDamage);
+  }
   delete gaPtr;
   delete [] datasetRegion;
-  delete [] dataStringArray;
-  if(bDataStringArrayAllocated) {
-    BL_ASSERT(maxAllowableLevel == pltAppStatePtr->MaxAllowableLevel());
-    for(int j(0); j <= maxAllowableLevel; ++j) {
-      delete [] myDataStringArray[j];
-    }
-    delete [] myDataStringArray;
-  }
+  ReleaseLevelData();
   XtDestroyWidget(wDatasetTopLevel);
 }
 
@@ -271,17 +401,9 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
 		            PltApp *pltappptr, PltAppState *pltappstateptr,
 			    int hdir, int vdir, int sdir)
 {
-  int i, c, d, stringCount;
-  Box boxTemp, dataBox;
-  Real *dataPoint; 
+  int i, d;
   
-  if(bDataStringArrayAllocated) {
-    BL_ASSERT(maxAllowableLevel == pltAppStatePtr->MaxAllowableLevel());
-    for(int j(0); j <= maxAllowableLevel; ++j) {
-      delete [] myDataStringArray[j];
-    }
-    delete [] myDataStringArray;
-  }
+  ReleaseLevelData();
   
   pltAppPtr = pltappptr;
   pltAppStatePtr = pltappstateptr;
@@ -308,8 +430,7 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
     vAxisString = "error";
   }
 
-  char fstring[Amrvis::BUFSIZE];
-  strcpy(fstring, pltAppStatePtr->GetFormatString().c_str());
+  formatString = pltAppStatePtr->GetFormatString();
   if( ! stringOk) {
     return;
   }
@@ -331,16 +452,12 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
   
   // datasetRegion is now an array of Boxes that encloses the selected region
   
-  Vector<FArrayBox *> dataFab(maxAllowableLevel + 1);
+  levelDataFab.resize(maxAllowableLevel + 1, nullptr);
+  levelBodyFab.resize(maxAllowableLevel + 1, nullptr);
   for(i = 0; i <= maxAllowableLevel; ++i) {
-    dataFab[i] = new FArrayBox(datasetRegion[i], 1);
+    levelDataFab[i] = new FArrayBox(datasetRegion[i], 1);
   }
   
-  Palette *palptr = pltAppPtr->GetPalettePtr();
-  int colorSlots(palptr->ColorSlots());
-  int paletteStart(palptr->PaletteStart());
-  int paletteEnd(palptr->PaletteEnd());
-  
   ostringstream outstr;
   outstr << AVGlobals::StripSlashes(pltAppPtr->GetFileName())
          << "  " << pltAppStatePtr->CurrentDerived()
@@ -349,64 +466,51 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
   XtVaSetValues(wDatasetTopLevel,
                 XmNtitle, const_cast<char *>(outstr.str().c_str()),
 		NULL);
-  // find largest data width and count # of data strings 
-  
-  int largestWidth(0);
+  // ---- read the data and find its range.  the strings are formatted
+  // ---- when drawn, only for the cells in view (see DrawDataStrings),
+  // ---- so the column width is estimated from the range
   Real rMin, rMax, levMin, levMax;
   rMin =  std::numeric_limits<Real>::max();
   rMax = -std::numeric_limits<Real>::max();
-  stringCount = 0;
-  myStringCount = new int[maxAllowableLevel + 1];
+  long nCells(0);
   for(int lev(0); lev <= maxAllowableLevel; ++lev) {
-    myStringCount[lev] = 0;
     DataServices::Dispatch(DataServices::FillVarOneFab, dataServicesPtr,
-                           (void *) dataFab[lev],
-			   (void *) &(dataFab[lev]->box()),
+                           (void *) levelDataFab[lev],
+			   (void *) &(levelDataFab[lev]->box()),
                            lev,
 			   (void *) &(pltAppStatePtr->CurrentDerived()));
 
     bool minMaxValid;
-    DataServices::Dispatch(DataServices::MinMaxRequest, dataServicesPtr,
-			   (void *) &(dataFab[lev]->box()),
-			   (void *) &(pltAppStatePtr->CurrentDerived()),
-			   lev, &levMin, &levMax, &minMaxValid);
-
+    GridRangeSummary::ForData(dataServicesPtr, pltAppStatePtr->CurrentDerived()).
+        MinMax(dataServicesPtr, levelDataFab[lev]->box(), lev, levMin, levMax, minMaxValid);
+
+    Vector<int> regionGrids;
+    GridIndex::Intersecting(amrData.boxArray(lev), datasetRegion[lev], regionGrids);
+    if( ! minMaxValid && regionGrids.size() > 0) {  // ---- use the data read
+      levMin =  std::numeric_limits<Real>::max();
+      levMax = -std::numeric_limits<Real>::max();
+      for(int iGrid(0); iGrid < regionGrids.size(); ++iGrid) {
+        Box dataBox(amrData.boxArray(lev)[regionGrids[iGrid]]);
+        dataBox &= datasetRegion[lev];
+        levMin = std::min(levMin, levelDataFab[lev]->min(dataBox, 0));
+        levMax = std::max(levMax, levelDataFab[lev]->max(dataBox, 0));
+      }
+      minMaxValid = true;
+    }
     if(minMaxValid) {
       rMin = std::min(rMin, levMin);
       rMax = std::max(rMax, levMax);
     }
-
-    for(int iBox(0); iBox < amrData.boxArray(lev).size(); ++iBox) {
-      boxTemp = amrData.boxArray(lev)[iBox];
-      if(datasetRegion[lev].intersects(boxTemp)) {
-        int ddl;
-        boxTemp &= datasetRegion[lev];
-        dataBox = boxTemp;
-        FArrayBox dataFabTemp(dataBox, 1);
-        dataFabTemp.copy(*(dataFab[lev]));
-        dataPoint = dataFabTemp.dataPtr();
-#if (BL_SPACEDIM == 1)
-        stringCount += 1 * dataBox.length(hDIR);
-        myStringCount[lev] +=  1 * dataBox.length(hDIR);
-#else
-        stringCount += dataBox.length(vDIR) * dataBox.length(hDIR);
-        myStringCount[lev] +=  dataBox.length(vDIR) * dataBox.length(hDIR);
-#endif
-	int highD(1);
-        if(BL_SPACEDIM > 1) {
-	  highD = dataBox.length(vDIR);
-	}
-        for(d = 0; d < highD; ++d) {
-          ddl = d * dataBox.length(hDIR);
-          for(c = 0; c < dataBox.length(hDIR); ++c) {
-            sprintf(dataString, fstring, dataPoint[c+ddl]);
-            largestWidth = std::max((int) strlen(dataString), largestWidth);
-          }
-        }
-      }
+    for(int iGrid(0); iGrid < regionGrids.size(); ++iGrid) {
+      Box dataBox(amrData.boxArray(lev)[regionGrids[iGrid]]);
+      dataBox &= datasetRegion[lev];
+      nCells += dataBox.numPts();
     }
   }
 
+  CellFormat cellFormat(formatString);
+  int largestWidth(EstimateWidth(cellFormat, rMin, rMax));
+
   // fix for cart grid body
   bool bCartGrid(dataServicesPtr->AmrDataRef().CartGrid());
   bool bShowBody(AVGlobals::GetShowBody());
@@ -430,13 +534,13 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
                 NULL);
   XmStringFree(sNewLevel);
   
-  sprintf(minInfoV, fstring, rMin);
+  cellFormat.Format(rMin, minInfoV, Amrvis::LINELENGTH);
   sprintf(minInfo, "Min:%s", minInfoV);
   XmString sNewMin = XmStringCreateSimple(minInfo);
   XtVaSetValues(wMinValue, XmNlabelString, sNewMin, NULL);
   XmStringFree(sNewMin);
 
-  sprintf(maxInfoV, fstring, rMax);
+  cellFormat.Format(rMax, maxInfoV, Amrvis::LINELENGTH);
   sprintf(maxInfo, "Max:%s", maxInfoV);
   XmString sNewMax = XmStringCreateSimple(maxInfo);
   XtVaSetValues(wMaxValue, XmNlabelString, sNewMax, NULL);
@@ -444,26 +548,8 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
 
   
   if(AVGlobals::Verbose()) {
-    cout << stringCount << " data points" << endl;
-  }
-  numStrings = stringCount;
-  dataStringArray = new StringLoc[numStrings];
-  for(int ns(0); ns < numStrings; ++ns) {
-    dataStringArray[ns].olflag = maxDrawnLevel;
+    cout << nCells << " data points" << endl;
   }
-  if(dataStringArray == NULL) {
-    cout << "Error in Dataset::DatasetRender:  out of memory" << endl;
-    return;
-  }
-  myDataStringArray = new StringLoc * [maxAllowableLevel + 1];
-  int level;
-  for(level = 0; level <= maxDrawnLevel; ++level) {
-    myDataStringArray[level] = new StringLoc [myStringCount[level] ];
-  }
-  for(level = maxDrawnLevel + 1; level <= maxAllowableLevel; ++level) {
-    myDataStringArray[level] = NULL;
-  }
-  bDataStringArrayAllocated = true;
 
   // determine the length of the character labels for the indices
 #if (BL_SPACEDIM == 1)
@@ -490,7 +576,6 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
              ((maxDrawnLevel - minDrawnLevel + 1) * indexHeight);
 #endif
   
-  // create StringLoc array and define color scheme 
   if(pixSizeX == 0 || pixSizeY == 0) {
     noData = true;
     sprintf (dataString, "No intersection.");
@@ -506,168 +591,26 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
                   XmNwidth,	pixSizeX,
                   XmNheight,	pixSizeY,
                   NULL);
-    
-    stringCount = 0; 
-    int lastLevLow(0), lastLevHigh(0);
-    int csm1(colorSlots - 1);
-    Real datamin, datamax;
-    pltAppStatePtr->GetMinMax(datamin, datamax);
-    Real globalDiff(datamax - datamin);
-    Real oneOverGlobalDiff;
-    if(globalDiff < FLT_MIN) {
-      oneOverGlobalDiff = 0.0;  // so we dont divide by zero
-    } else {
-      oneOverGlobalDiff = 1.0 / globalDiff;
-    }
-
-    for(int lev(minDrawnLevel); lev <= maxDrawnLevel; ++lev) {
-      for(int iBox(0); iBox < amrData.boxArray(lev).size(); ++iBox) {
-        boxTemp = amrData.boxArray(lev)[iBox];
-        if(datasetRegion[lev].intersects(boxTemp)) {
-          boxTemp &= datasetRegion[lev];
-          dataBox = boxTemp;
-          boxTemp.refine(amrex::CRRBetweenLevels(lev, maxDrawnLevel,
-	              amrData.RefRatio()));
-          boxTemp.shift(hDIR, -datasetRegion[maxDrawnLevel].smallEnd(hDIR)); 
-#if (BL_SPACEDIM != 1)
-          boxTemp.shift(vDIR, -datasetRegion[maxDrawnLevel].smallEnd(vDIR)); 
-#endif
-          FArrayBox dataFabTemp(dataBox, 1);
-          dataFabTemp.copy(*(dataFab[lev]));
-          dataPoint = dataFabTemp.dataPtr();
-          int ddl;
-          int crr = amrex::CRRBetweenLevels(lev, maxDrawnLevel,
-	                                        amrData.RefRatio());
-	  Real amrmin(datamin), amrmax(datamax);
-          
-	  int highD(1);
-          if(BL_SPACEDIM > 1) {
-	    highD = dataBox.length(vDIR);
-	  }
-          for(d = 0; d < highD; ++d) {
-            ddl = d * dataBox.length(hDIR);
-            for(c = 0; c < dataBox.length(hDIR); ++c) {
-              sprintf(dataString, fstring, dataPoint[c+ddl]);
-              if(dataPoint[c+ddl] > amrmax) {
-                dataStringArray[stringCount].color = paletteEnd;    // clip
-              } else if(dataPoint[c+ddl] < amrmin) {
-                dataStringArray[stringCount].color = paletteStart;  // clip
-              } else {
-                dataStringArray[stringCount].color = (int)
-                  (((dataPoint[c+ddl] - datamin) * oneOverGlobalDiff) * csm1 ); 
-                dataStringArray[stringCount].color += paletteStart;
-              }	
-              dataStringArray[stringCount].xloc = (boxTemp.smallEnd(hDIR)
-                                                   + c * crr) * dataItemWidth + 5;
-#if (BL_SPACEDIM == 1)
-              dataStringArray[stringCount].yloc = pixSizeY-1 -
-                (0 + d * crr) * CHARACTERHEIGHT - 4;
-#else
-              dataStringArray[stringCount].yloc = pixSizeY-1 -
-                (boxTemp.smallEnd(vDIR) + d * crr) * CHARACTERHEIGHT - 4;
-#endif
-
-              for(i = lastLevLow; i < lastLevHigh; ++i) { // remove overlap
-                if(dataStringArray[i].xloc == dataStringArray[stringCount].xloc &&
-                   dataStringArray[i].yloc == dataStringArray[stringCount].yloc)
-                {
-                  dataStringArray[i].olflag = lev - 1; 
-                  // highest level at which visible
-                }
-              }	
-              
-              strcpy(dataStringArray[stringCount].ds, dataString);
-              dataStringArray[stringCount].dslen = strlen(dataString);
-              
-              if(bIsMF && lev == 0) {  // fix level zero data
-                strcpy(dataStringArray[stringCount].ds, "no data");
-                dataStringArray[stringCount].dslen = strlen("no data");
-                dataStringArray[stringCount].color = palptr->WhiteIndex();
-              }
-
-	      if(bTimeline) {
-		string mfnString(pltappptr->GetMPIFName(dataPoint[c+ddl]));
-                strcpy(dataStringArray[stringCount].ds, mfnString.c_str());
-                dataStringArray[stringCount].dslen = strlen(mfnString.c_str());
-	      }
-
-	      if(bRegions) {
-		string mfnString(pltappptr->GetRegionName(dataPoint[c+ddl]));
-                strcpy(dataStringArray[stringCount].ds, mfnString.c_str());
-                dataStringArray[stringCount].dslen = strlen(mfnString.c_str());
-	      }
-
-              ++stringCount;
-              
-            }  // end for(c...)
-          }  // end for(d...)
-          
-        }  // end if(datasetRegion[lev].intersects(boxTemp))
-      }
-      lastLevLow = lastLevHigh;
-      lastLevHigh = stringCount; 
-    }
   }  // end if(pixSizeX...)
   
 
   // fix for cart grid body
   if(bCartGrid && pltAppStatePtr->CurrentDerived() != vfDerived && bShowBody) {
-    int stringCountCG(0);
     for(int lev(minDrawnLevel); lev <= maxDrawnLevel; ++lev) {
-      FArrayBox cgDataFab(datasetRegion[lev], 1);
-      Real vfeps = dataServicesPtr->AmrDataRef().VfEps(lev);
+      levelBodyFab[lev] = new FArrayBox(datasetRegion[lev], 1);
       DataServices::Dispatch(DataServices::FillVarOneFab, dataServicesPtr,
-                             (void *) &cgDataFab,
-			     (void *) &(cgDataFab.box()),
+                             (void *) levelBodyFab[lev],
+			     (void *) &(levelBodyFab[lev]->box()),
                              lev,
 			     (void *) &vfDerived);
-
-      int crr = amrex::CRRBetweenLevels(lev, maxDrawnLevel,
-	                                    amrData.RefRatio());
-      for(int iBox(0); iBox < amrData.boxArray(lev).size(); ++iBox) {
-        Box sBoxTemp = amrData.boxArray(lev)[iBox];
-        if(datasetRegion[lev].intersects(sBoxTemp)) {
-          sBoxTemp &= datasetRegion[lev];
-          Box sDataBox(sBoxTemp);
-          sBoxTemp.refine(crr);
-          sBoxTemp.shift(hDIR, -datasetRegion[maxDrawnLevel].smallEnd(hDIR)); 
-#if (BL_SPACEDIM != 1)
-          sBoxTemp.shift(vDIR, -datasetRegion[maxDrawnLevel].smallEnd(vDIR)); 
-#endif
-          FArrayBox cgDataFabTemp(sDataBox, 1);
-          cgDataFabTemp.copy(cgDataFab);
-          Real *sDataPoint = cgDataFabTemp.dataPtr();
-          
-	  int highD(1);
-          if(BL_SPACEDIM > 1) {
-	    highD = sDataBox.length(vDIR);
-	  }
-          for(int ddss(0); ddss < highD; ++ddss) {
-            int ddl(ddss * sDataBox.length(hDIR));
-            for(int ccss(0); ccss < sDataBox.length(hDIR); ++ccss) {
-	      if(sDataPoint[ccss+ddl] < vfeps) {
-                dataStringArray[stringCountCG].color = palptr->WhiteIndex();
-                strcpy(dataStringArray[stringCountCG].ds, "body");
-                dataStringArray[stringCountCG].dslen = strlen("body");
-	      }
-              
-              ++stringCountCG;
-              
-            }  // end for(ccss...)
-          }  // end for(ddss...)
-          
-        }  // end if(datasetRegion[lev].intersects(sBoxTemp))
-      }
     }
   }
 
-
-  // now load into **StringLoc
-  int sCount(0);
-  for(int lev(minDrawnLevel); lev <= maxDrawnLevel; ++lev) {
-    for(stringCount = 0; stringCount < myStringCount[lev]; ++stringCount) {
-      myDataStringArray[lev][stringCount] = dataStringArray[sCount];
-      ++sCount;
+  // ---- only the drawn levels are needed from here on
+  for(int lev(0); lev <= maxAllowableLevel; ++lev) {
+    if(lev < minDrawnLevel || lev > maxDrawnLevel) {
+      delete levelDataFab[lev];
+      levelDataFab[lev] = nullptr;
     }
   }
 
@@ -761,14 +704,23 @@ void Dataset::DatasetRender(const Box &alignedRegion, AmrPicture *apptr,
         vIndexArray[sLevel][d].olflag = false;
       }
   }
-  
-  for(i = 0; i < dataFab.size(); ++i) {
-    delete dataFab[i];
-  }
 
 }  // end Dataset::DatasetRender
 
 
+// -------------------------------------------------------------------
+void Dataset::ReleaseLevelData() {
+  for(int lev(0); lev < levelDataFab.size(); ++lev) {
+    delete levelDataFab[lev];
+  }
+  for(int lev(0); lev < levelBodyFab.size(); ++lev) {
+    delete levelBodyFab[lev];
+  }
+  levelDataFab.clear();
+  levelBodyFab.clear();
+}
+
+
 // -------------------------------------------------------------------
 void Dataset::DrawGrid(int startX, int startY, int finishX, int finishY, 
                        int gridspacingX, int gridspacingY,
@@ -989,7 +941,6 @@ void Dataset::DoExpose(int fromExpose) {
         return;
     }
     
-    Palette *palptr = pltAppPtr->GetPalettePtr();
     dataServicesPtr = pltAppPtr->GetDataServicesPtr();
     const AmrData &amrData = dataServicesPtr->AmrDataRef();
     if(noData) {
@@ -999,7 +950,7 @@ void Dataset::DoExpose(int fromExpose) {
         XDrawString(XtDisplay(wPixArea), XtWindow(wPixArea), gaPtr->PGC(),
                     2, pixSizeY-5, dataString, strlen(dataString));
     } else {
-        unsigned int lev, stringCount;
+        unsigned int lev;
         Box temp, dataBox;
         Widget hScrollBar, vScrollBar;
         Dimension wdth, hght;
@@ -1048,7 +999,33 @@ void Dataset::DoExpose(int fromExpose) {
         
         XtVaGetValues(wScrollArea, XmNwidth, &wdth, XmNheight, &hght, NULL);
         
-        XClearWindow(gaPtr->PDisplay(), XtWindow(wPixArea));
+        // ---- strings are drawn if xloc and yloc are inside these
+#ifndef SCROLLBARERROR
+        int drawLoH(hScrollBarPos - dataItemWidth), drawHiH(hScrollBarPos + wdth);
+        int drawLoV(vScrollBarPos - dataItemWidth), drawHiV(vScrollBarPos + hght);
+#else
+        int drawLoH(-dataItemWidth),   drawHiH(pixSizeX + dataItemWidth);
+        int drawLoV(-CHARACTERHEIGHT), drawHiV(pixSizeY + CHARACTERHEIGHT);
+#endif
+        
+        if(fromExpose && exposeDamage != nullptr) {
+          // ---- the gc is clipped to the damage, see CBDoExposeDataset.
+          // ---- only the damage is cleared, the rest of its bounding
+          // ---- box is not redrawn.
+          XRectangle area;
+          XClipBox(exposeDamage, &area);
+          Pixel backgroundPixel;
+          XtVaGetValues(wPixArea, XmNbackground, &backgroundPixel, NULL);
+          XSetForeground(gaPtr->PDisplay(), gaPtr->PGC(), backgroundPixel);
+          XFillRectangle(gaPtr->PDisplay(), XtWindow(wPixArea), gaPtr->PGC(),
+                         area.x, area.y, area.width, area.height);
+          drawLoH = std::max(drawLoH, area.x - dataItemWidth);
+          drawHiH = std::min(drawHiH, area.x + area.width);
+          drawLoV = std::max(drawLoV, area.y - CHARACTERHEIGHT);
+          drawHiV = std::min(drawHiV, area.y + area.height + CHARACTERHEIGHT);
+        } else {
+          XClearWindow(gaPtr->PDisplay(), XtWindow(wPixArea));
+        }
         
         int min_level(minDrawnLevel);
         int max_level(maxDrawnLevel);
@@ -1056,39 +1033,39 @@ void Dataset::DoExpose(int fromExpose) {
         
         // draw grid structure for entire region 
         for(lev = minDrawnLevel; lev <= maxDrawnLevel; ++lev) {
-            for(int iBox(0); iBox < amrData.boxArray(lev).size(); ++iBox) {
-                temp = amrData.boxArray(lev)[iBox];
-                if(datasetRegion[lev].intersects(temp)) {
-                    temp &= datasetRegion[lev];
-                    dataBox = temp;
-                    temp.refine(amrex::CRRBetweenLevels(lev,
-                                            maxDrawnLevel, amrData.RefRatio()));
-                    temp.shift(hDIR, -datasetRegion[maxDrawnLevel].smallEnd(hDIR)); 
+            Vector<int> regionGrids;
+            GridIndex::Intersecting(amrData.boxArray(lev), datasetRegion[lev], regionGrids);
+            for(int iGrid(0); iGrid < regionGrids.size(); ++iGrid) {
+                temp = amrData.boxArray(lev)[regionGrids[iGrid]];
+                temp &= datasetRegion[lev];
+                dataBox = temp;
+                temp.refine(amrex::CRRBetweenLevels(lev,
+                                        maxDrawnLevel, amrData.RefRatio()));
+                temp.shift(hDIR, -datasetRegion[maxDrawnLevel].smallEnd(hDIR)); 
 #if (BL_SPACEDIM != 1)
-                    temp.shift(vDIR, -datasetRegion[maxDrawnLevel].smallEnd(vDIR));
+                temp.shift(vDIR, -datasetRegion[maxDrawnLevel].smallEnd(vDIR));
 #endif
 #if (BL_SPACEDIM == 1)
-                    DrawGrid(temp.smallEnd(hDIR) * dataItemWidth,
-                           (pixSizeY-1 - (0+1) * CHARACTERHEIGHT)
-                           -((level_diff+1)*hIndexAreaHeight),
-                           (temp.bigEnd(hDIR)+1) * dataItemWidth,
-                           (pixSizeY-1 - 0 * CHARACTERHEIGHT)
-                           -((level_diff+1)*hIndexAreaHeight),
-                           amrex::CRRBetweenLevels(lev, maxDrawnLevel,
-			                               amrData.RefRatio()),
-                           whiteIndex, blackIndex);
+                DrawGrid(temp.smallEnd(hDIR) * dataItemWidth,
+                       (pixSizeY-1 - (0+1) * CHARACTERHEIGHT)
+                       -((level_diff+1)*hIndexAreaHeight),
+                       (temp.bigEnd(hDIR)+1) * dataItemWidth,
+                       (pixSizeY-1 - 0 * CHARACTERHEIGHT)
+                       -((level_diff+1)*hIndexAreaHeight),
+                       amrex::CRRBetweenLevels(lev, maxDrawnLevel,
+                                                   amrData.RefRatio()),
+                       whiteIndex, blackIndex);
 #else
-                    DrawGrid(temp.smallEnd(hDIR) * dataItemWidth,
-                           (pixSizeY-1 - (temp.bigEnd(vDIR)+1) * CHARACTERHEIGHT)
-                           -((level_diff+1)*hIndexAreaHeight),
-                           (temp.bigEnd(hDIR)+1) * dataItemWidth,
-                           (pixSizeY-1 - temp.smallEnd(vDIR) * CHARACTERHEIGHT)
-                           -((level_diff+1)*hIndexAreaHeight),
-                           amrex::CRRBetweenLevels(lev, maxDrawnLevel,
-			                               amrData.RefRatio()),
-                           whiteIndex, blackIndex);
+                DrawGrid(temp.smallEnd(hDIR) * dataItemWidth,
+                       (pixSizeY-1 - (temp.bigEnd(vDIR)+1) * CHARACTERHEIGHT)
+                       -((level_diff+1)*hIndexAreaHeight),
+                       (temp.bigEnd(hDIR)+1) * dataItemWidth,
+                       (pixSizeY-1 - temp.smallEnd(vDIR) * CHARACTERHEIGHT)
+                       -((level_diff+1)*hIndexAreaHeight),
+                       amrex::CRRBetweenLevels(lev, maxDrawnLevel,
+                                                   amrData.RefRatio()),
+                       whiteIndex, blackIndex);
 #endif
-                }
             }
         }
         if(dragging) {
@@ -1096,67 +1073,163 @@ void Dataset::DoExpose(int fromExpose) {
           return;
         }
         
-        int xloc, yloc;
-        int sXhh((int) hScrollBarPos - dataItemWidth);
-        int sYvv((int) vScrollBarPos - dataItemWidth);
-        
         // draw data strings
-        if(XmToggleButtonGetState(wColorButton)) {
-          for(int lvl = minDrawnLevel; lvl <= maxDrawnLevel; ++lvl) {
-            for(stringCount = 0; stringCount < myStringCount[lvl]; ++stringCount) {
-              xloc = myDataStringArray[lvl][stringCount].xloc;
-              yloc = myDataStringArray[lvl][stringCount].yloc -
-		     ((maxDrawnLevel-minDrawnLevel+1)*hIndexAreaHeight);
-#ifndef SCROLLBARERROR
-              if(myDataStringArray[lvl][stringCount].olflag >= maxDrawnLevel  &&
-                 xloc > sXhh && yloc > sYvv &&
-                 xloc < hScrollBarPos+wdth && yloc < vScrollBarPos+hght)
-#else
-              if(myDataStringArray[lvl][stringCount].olflag >= maxDrawnLevel)
+        DrawDataStrings(drawLoH, drawLoV, drawHiH, drawHiV);
+        DrawIndices();
+    }
+}  // end DoExpose
+
+
+// -------------------------------------------------------------------
+// ---- format and draw the data strings with xloc and yloc inside
+// ---- (drawLoH, drawHiH) and (drawLoV, drawHiV).  only the cells in
+// ---- that range are looked at, so the cost is set by the window
+// ---- size, not the region size.  a cell is drawn at its lower left
+// ---- corner on the finest drawn level, and not at all if the next
+// ---- finer level has a cell there.
+void Dataset::DrawDataStrings(int drawLoH, int drawLoV, int drawHiH, int drawHiV) {
+  if(levelDataFab.size() <= maxDrawnLevel) {  // ---- not rendered
+    return;
+  }
+  const AmrData &amrData = dataServicesPtr->AmrDataRef();
+  Display *display = XtDisplay(wPixArea);
+  Window dataWindow = XtWindow(wPixArea);
+  GC gc = gaPtr->PGC();
+  Palette *palptr = pltAppPtr->GetPalettePtr();
+
+  bool bColor(XmToggleButtonGetState(wColorButton));
+  if( ! bColor) {
+    Pixel foregroundPix;
+    XtVaGetValues(wPixArea, XmNforeground, &foregroundPix, NULL);
+    XSetForeground(display, gc, foregroundPix);
+  }
+  int csm1(palptr->ColorSlots() - 1);
+  int paletteStart(palptr->PaletteStart());
+  int paletteEnd(palptr->PaletteEnd());
+  Real datamin, datamax;
+  pltAppStatePtr->GetMinMax(datamin, datamax);
+  Real globalDiff(datamax - datamin);
+  Real oneOverGlobalDiff;
+  if(globalDiff < FLT_MIN) {
+    oneOverGlobalDiff = 0.0;  // so we dont divide by zero
+  } else {
+    oneOverGlobalDiff = 1.0 / globalDiff;
+  }
+  bool bIsMF(dataServicesPtr->GetFileType() == Amrvis::MULTIFAB);
+  CellFormat cellFormat(formatString);
+  char cellString[MAXSTRINGWIDTH];
+  string nameString;
+
+  // ---- a finest drawn level cell rel cells from the region corner
+  // ---- is at xloc = relH * dataItemWidth + 5, yloc = yBase - relV * CHARACTERHEIGHT
+  const Box &drawnRegion = datasetRegion[maxDrawnLevel];
+  int yBase(pixSizeY - 1 - 4 - (maxDrawnLevel - minDrawnLevel + 1) * hIndexAreaHeight);
+  Box inView(drawnRegion);
+  inView.setSmall(hDIR, std::max(drawnRegion.smallEnd(hDIR),
+                  drawnRegion.smallEnd(hDIR) + (drawLoH - 5) / dataItemWidth - 1));
+  inView.setBig(hDIR, std::min(drawnRegion.bigEnd(hDIR),
+                drawnRegion.smallEnd(hDIR) + (drawHiH - 5) / dataItemWidth + 1));
+#if (BL_SPACEDIM != 1)
+  inView.setSmall(vDIR, std::max(drawnRegion.smallEnd(vDIR),
+                  drawnRegion.smallEnd(vDIR) + (yBase - drawHiV) / CHARACTERHEIGHT - 1));
+  inView.setBig(vDIR, std::min(drawnRegion.bigEnd(vDIR),
+                drawnRegion.smallEnd(vDIR) + (yBase - drawLoV) / CHARACTERHEIGHT + 1));
 #endif
-              { 
-                XSetForeground(XtDisplay(wPixArea), gaPtr->PGC(), 
-                     palptr->makePixel(myDataStringArray[lvl][stringCount].color)); 
-                XDrawString(XtDisplay(wPixArea), XtWindow(wPixArea),
-                            gaPtr->PGC(), xloc, yloc,
-                            myDataStringArray[lvl][stringCount].ds,
-                            myDataStringArray[lvl][stringCount].dslen);
-              }
-            }  // end for
-          }  // end for
-        } else {
-	    Pixel foregroundPix, backgroundPix;
-	    XtVaGetValues(wPixArea,
-	                  XmNforeground, &foregroundPix,
-			  XmNbackground, &backgroundPix,
-			  NULL);
-
-            //XSetForeground(XtDisplay(wPixArea), gaPtr->PGC(), whiteIndex);
-            XSetForeground(XtDisplay(wPixArea), gaPtr->PGC(), foregroundPix);
-            for(int lvl(minDrawnLevel); lvl <= maxDrawnLevel; ++lvl) {
-              for(stringCount=0; stringCount < myStringCount[lvl]; ++stringCount) {
-                xloc = myDataStringArray[lvl][stringCount].xloc;
-                yloc = myDataStringArray[lvl][stringCount].yloc -
-		       ((max_level-min_level+1)*hIndexAreaHeight);
-#ifndef SCROLLBARERROR
-                if(myDataStringArray[lvl][stringCount].olflag >= maxDrawnLevel &&
-                   xloc > sXhh && yloc > sYvv &&
-                   xloc < hScrollBarPos+wdth && yloc < vScrollBarPos+hght)
+  if( ! inView.ok()) {
+    return;
+  }
+
+  for(int lev(minDrawnLevel); lev <= maxDrawnLevel; ++lev) {
+    int crr(amrex::CRRBetweenLevels(lev, maxDrawnLevel, amrData.RefRatio()));
+    Box levelView(amrex::coarsen(inView, crr));
+    levelView &= datasetRegion[lev];
+    if( ! levelView.ok()) {
+      continue;
+    }
+
+    // ---- the finer grids in view, which hide the cells under them
+    Vector<Box> finerBoxes;
+    int finerRatio(1);
+    if(lev < maxDrawnLevel) {
+      finerRatio = amrData.RefRatio()[lev];
+      Box finerView(amrex::refine(levelView, finerRatio));
+      finerView &= datasetRegion[lev + 1];
+      Vector<int> finerGrids;
+      GridIndex::Intersecting(amrData.boxArray(lev + 1), finerView, finerGrids);
+      for(int iGrid(0); iGrid < finerGrids.size(); ++iGrid) {
+        finerBoxes.push_back(amrData.boxArray(lev + 1)[finerGrids[iGrid]] & finerView);
+      }
+    }
+
+    const FArrayBox &dataFab = *levelDataFab[lev];
+    const FArrayBox *bodyFab = levelBodyFab[lev];
+    Real vfeps(bodyFab != nullptr ? amrData.VfEps(lev) : 0.0);
+    Vector<int> regionGrids;
+    GridIndex::Intersecting(amrData.boxArray(lev), levelView, regionGrids);
+    for(int iGrid(0); iGrid < regionGrids.size(); ++iGrid) {
+      Box cellBox(amrData.boxArray(lev)[regionGrids[iGrid]]);
+      cellBox &= levelView;
+      for(IntVect iv(cellBox.smallEnd()); iv <= cellBox.bigEnd(); cellBox.next(iv)) {
+        int xloc((iv[hDIR] * crr - drawnRegion.smallEnd(hDIR)) * dataItemWidth + 5);
+#if (BL_SPACEDIM == 1)
+        int yloc(yBase);
 #else
-                if(myDataStringArray[lvl][stringCount].olflag >= maxDrawnLevel)
+        int yloc(yBase - (iv[vDIR] * crr - drawnRegion.smallEnd(vDIR)) * CHARACTERHEIGHT);
 #endif
-                {
-                        XDrawString(XtDisplay(wPixArea), XtWindow(wPixArea),
-                                    gaPtr->PGC(), xloc, yloc,
-                                    myDataStringArray[lvl][stringCount].ds,
-                                    myDataStringArray[lvl][stringCount].dslen);
-                }
-              }
-            }
+        if(xloc <= drawLoH || xloc >= drawHiH || yloc <= drawLoV || yloc >= drawHiV) {
+          continue;
         }
-        DrawIndices();
+        if(finerBoxes.size() > 0) {
+          IntVect finerCorner(iv * finerRatio);
+#if (BL_SPACEDIM == 3)
+          finerCorner[sDIR] = datasetRegion[lev + 1].smallEnd(sDIR);
+#endif
+          bool bHidden(false);
+          for(int iBox(0); iBox < finerBoxes.size() && ! bHidden; ++iBox) {
+            bHidden = finerBoxes[iBox].contains(finerCorner);
+          }
+          if(bHidden) {
+            continue;
+          }
+        }
+
+        Real value(dataFab(iv));
+        int color;
+        if(value > datamax) {
+          color = paletteEnd;    // clip
+        } else if(value < datamin) {
+          color = paletteStart;  // clip
+        } else {
+          color = (int) (((value - datamin) * oneOverGlobalDiff) * csm1);
+          color += paletteStart;
+        }
+        const char *ds(cellString);
+        if(bodyFab != nullptr && (*bodyFab)(iv) < vfeps) {
+          ds = "body";
+          color = palptr->WhiteIndex();
+        } else if(bRegions) {
+          nameString = pltAppPtr->GetRegionName(value);
+          ds = nameString.c_str();
+        } else if(bTimeline) {
+          nameString = pltAppPtr->GetMPIFName(value);
+          ds = nameString.c_str();
+        } else if(bIsMF && lev == 0) {  // fix level zero data
+          ds = "no data";
+        } else {
+          cellFormat.Format(value, cellString, MAXSTRINGWIDTH);
+        }
+        if(bIsMF && lev == 0) {
+          color = palptr->WhiteIndex();
+        }
+
+        if(bColor) {
+          XSetForeground(display, gc, palptr->makePixel(color));
+        }
+        XDrawString(display, dataWindow, gc, xloc, yloc, ds, strlen(ds));
+      }
     }
-}  // end DoExpose
+  }
+}  // end DrawDataStrings
 
 
 // -------------------------------------------------------------------
@@ -1278,18 +1351,50 @@ void Dataset::DrawIndices() {
 
 
 // -------------------------------------------------------------------
-void Dataset::CBDoExposeDataset(Widget, XtPointer client_data, XEvent *, Boolean *)
+void Dataset::CBDoExposeDataset(Widget, XtPointer client_data, XEvent *event, Boolean *)
 {
-  XEvent nextEvent;
+  if(event->type != Expose) {
+    return;
+  }
   Dataset *dset = (Dataset *) client_data;
-  while(XCheckTypedWindowEvent(dset->gaPtr->PDisplay(),
-                               XtWindow(dset->wPixArea), Expose, &nextEvent))
-  {
+  Display *display = dset->gaPtr->PDisplay();
+  if(dset->exposeDamage == nullptr) {
+    dset->exposeDamage = XCreateRegion();
+  }
+
+  // ---- merge this and the queued expose rectangles, and wait
+  // ---- for the last event of the series before drawing
+  XEvent nextEvent;
+  XExposeEvent *xexpose = &event->xexpose;
+  XRectangle exposed;
+  int count(0);
+  while(true) {
+    exposed.x = xexpose->x;
+    exposed.y = xexpose->y;
+    exposed.width  = xexpose->width;
+    exposed.height = xexpose->height;
+    XUnionRectWithRegion(&exposed, dset->exposeDamage, dset->exposeDamage);
+    count = xexpose->count;
+    if( ! XCheckTypedWindowEvent(display, XtWindow(dset->wPixArea),
+                                 Expose, &nextEvent))
+    {
+      break;
+    }
     if(dset->drags) {
       dset->drags--;
     }
+    xexpose = &nextEvent.xexpose;
   }
+  if(count > 0) {
+    return;
+  }
+
+  GC gc = dset->gaPtr->PGC();
+  XSetRegion(display, gc, dset->exposeDamage);
   dset->DoExpose(true);
+  XSetClipMask(display, gc, None);
+  XDestroyRegion(dset->exposeDamage);
+  dset->exposeDamage = nullptr;
 }
 
 
@@ -0,0 +1,216 @@
+// ---------------------------------------------------------------
+// FrameCache.cpp
+// ---------------------------------------------------------------
+#include <FrameCache.H>
+#include <ImageKernels.H>
+
+#include <algorithm>
+using std::endl;
+
+
+// -------------------------------------------------------------------
+CachedFrame::CachedFrame()
+  : dataSizeH(0),
+    dataSizeV(0),
+    scale(1),
+    minBoxLevel(0),
+    ximage(nullptr)
+{ }
+
+
+// -------------------------------------------------------------------
+CachedFrame::~CachedFrame() {
+  if(ximage != nullptr) {
+    XDestroyImage(ximage);
+  }
+}
+
+
+// -------------------------------------------------------------------
+long CachedFrame::Bytes() const {
+  long bytes(encodedIndexData.size());
+  for(int lev(0); lev < gridSegments.size(); ++lev) {
+    bytes += gridSegments[lev].size() * sizeof(XSegment);
+  }
+  if(ximage != nullptr) {
+    bytes += static_cast<long>(ximage->bytes_per_line) * ximage->height;
+  }
+  return bytes;
+}
+
+
+// -------------------------------------------------------------------
+long CachedFrame::RawBytes() const {
+  return Bytes() - encodedIndexData.size() + (IsIndexFrame() ? IndexBytes() : 0);
+}
+
+
+// -------------------------------------------------------------------
+void CachedFrame::SetIndexData(const unsigned char *idata,
+                               int datasizeh, int datasizev)
+{
+  dataSizeH = datasizeh;
+  dataSizeV = datasizev;
+  AVImage::RunLengthEncode(idata, IndexBytes(), encodedIndexData);
+}
+
+
+// -------------------------------------------------------------------
+void CachedFrame::GetIndexData(unsigned char *idata) const {
+  AVImage::RunLengthDecode(encodedIndexData.dataPtr(), encodedIndexData.size(),
+                           idata, IndexBytes());
+}
+
+
+// -------------------------------------------------------------------
+FrameCache &FrameCache::TheFrameCache() {
+  static FrameCache theFrameCache;
+  return theFrameCache;
+}
+
+
+// -------------------------------------------------------------------
+FrameCache::FrameCache()
+  : maxBytes(1024L * 1024L * 1024L),
+    nBytes(0),
+    nRawBytes(0),
+    nHits(0),
+    nMisses(0),
+    nEvictions(0),
+    nDecodes(0),
+    decodeTime(0.0)
+{ }
+
+
+// -------------------------------------------------------------------
+void FrameCache::SetMaxBytes(long maxbytes) {
+  maxBytes = std::max(0L, maxbytes);
+  EvictToFit(0);
+}
+
+
+// -------------------------------------------------------------------
+CachedFrame *FrameCache::Find(const void *owner, int frame) {
+  std::map<FrameKey, FrameEntry>::iterator it(frames.find(FrameKey(owner, frame)));
+  if(it == frames.end()) {
+    ++nMisses;
+    return nullptr;
+  }
+  ++nHits;
+  lruList.splice(lruList.begin(), lruList, it->second.lruPos);
+  return it->second.cframe;
+}
+
+
+// -------------------------------------------------------------------
+CachedFrame *FrameCache::Peek(const void *owner, int frame) const {
+  std::map<FrameKey, FrameEntry>::const_iterator it(frames.find(FrameKey(owner, frame)));
+  if(it == frames.end()) {
+    return nullptr;
+  }
+  return it->second.cframe;
+}
+
+
+// -------------------------------------------------------------------
+void FrameCache::Insert(const void *owner, int frame, CachedFrame *cframe) {
+  FrameKey key(owner, frame);
+  std::map<FrameKey, FrameEntry>::iterator it(frames.find(key));
+  if(it != frames.end()) {
+    if(it->second.cframe == cframe) {
+      lruList.splice(lruList.begin(), lruList, it->second.lruPos);
+      return;
+    }
+    EraseEntry(it);
+  }
+  long bytes(cframe->Bytes());
+  EvictToFit(bytes);
+  lruList.push_front(key);
+  FrameEntry &entry = frames[key];
+  entry.cframe = cframe;
+  entry.bytes    = bytes;
+  entry.rawBytes = cframe->RawBytes();
+  entry.lruPos   = lruList.begin();
+  nBytes    += bytes;
+  nRawBytes += entry.rawBytes;
+}
+
+
+// -------------------------------------------------------------------
+void FrameCache::Erase(const void *owner, int frame) {
+  std::map<FrameKey, FrameEntry>::iterator it(frames.find(FrameKey(owner, frame)));
+  if(it != frames.end()) {
+    EraseEntry(it);
+  }
+}
+
+
+// -------------------------------------------------------------------
+void FrameCache::EraseOwner(const void *owner) {
+  std::map<FrameKey, FrameEntry>::iterator it(frames.lower_bound(FrameKey(owner, 0)));
+  // ---- frame numbers are nonnegative, so the owner's frames are contiguous
+  while(it != frames.end() && it->first.first == owner) {
+    std::map<FrameKey, FrameEntry>::iterator itErase(it++);
+    EraseEntry(itErase);
+  }
+}
+
+
+// -------------------------------------------------------------------
+void FrameCache::EraseOwnerImageFrames(const void *owner) {
+  std::map<FrameKey, FrameEntry>::iterator it(frames.lower_bound(FrameKey(owner, 0)));
+  while(it != frames.end() && it->first.first == owner) {
+    std::map<FrameKey, FrameEntry>::iterator itErase(it++);
+    if( ! itErase->second.cframe->IsIndexFrame()) {
+      EraseEntry(itErase);
+    }
+  }
+}
+
+
+// -------------------------------------------------------------------
+int FrameCache::FramesInBudget(long framebytes) const {
+  if(framebytes <= 0) {
+    return 1;
+  }
+  return static_cast<int>(std::max(1L, maxBytes / framebytes));
+}
+
+
+// -------------------------------------------------------------------
+void FrameCache::PrintStats(ostream &os) const {
+  os << "FrameCache:  " << frames.size() << " frames, " << nBytes
+     << " of " << maxBytes << " bytes, hits = " << nHits
+     << ", misses = " << nMisses << ", evictions = " << nEvictions << endl;
+  if(nBytes > 0) {
+    os << "FrameCache:  compression ratio = "
+       << static_cast<double>(nRawBytes) / nBytes << endl;
+  }
+  if(nDecodes > 0) {
+    os << "FrameCache:  " << nDecodes << " decodes, average decode time = "
+       << decodeTime / nDecodes << " s" << endl;
+  }
+}
+
+
+// -------------------------------------------------------------------
+// ---- remove least recently used frames until newbytes more fit.
+// ---- an empty cache always takes the new frame, even over budget.
+void FrameCache::EvictToFit(long newbytes) {
+  while( ! lruList.empty() && nBytes + newbytes > maxBytes) {
+    EraseEntry(frames.find(lruList.back()));
+    ++nEvictions;
+  }
+}
+
+
+// -------------------------------------------------------------------
+void FrameCache::EraseEntry(std::map<FrameKey, FrameEntry>::iterator it) {
+  nBytes    -= it->second.bytes;
+  nRawBytes -= it->second.rawBytes;
+  lruList.erase(it->second.lruPos);
+  delete it->second.cframe;
+  frames.erase(it);
+}
+// ---------------------------------------------------------------
+// ---------------------------------------------------------------
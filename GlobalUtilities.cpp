@@ -14,6 +14,7 @@ using std::cerr;
 using std::endl;
 
 #include <PltApp.H>
+#include <FrameCache.H>
 #include <AMReX_ParallelDescriptor.H>
 
 extern void PrintProfParserBatchUsage(std::ostream &os);
@@ -30,6 +31,15 @@ Amrvis::FileType fileType;
 bool bAnimation;
 bool bAnnotated;
 bool bCacheAnimFrames;
+int  prefetchFrames(2);
+int  maxOpenFiles(64);
+long previewCells(2097152);
+long volumeMemMB(8192);
+long slabCacheMB(256);
+bool bRangeIndexFiles(false);
+bool bUseMITSHM(true);
+string classifyCacheDir;
+long classifyCacheMB(16384);
 Vector<string> comlinefilename;
 string initialDerived;
 string initialFormat;
@@ -359,6 +369,42 @@ void AVGlobals::GetDefaults(const string &defaultsFile) {
         sscanf(buffer, "%s%d", defaultString, &tempInt);
         maxPictureSize = tempInt;
       }
+      else if(strcmp(defaultString, "framecachemb") == 0) {
+        sscanf(buffer, "%s%d", defaultString, &tempInt);
+        if(tempInt < 0) {
+          cerr << "Error in defaults file:  invalid parameter for framecachemb:  "
+               << tempInt << endl;
+        } else {
+          FrameCache::TheFrameCache().SetMaxBytes(tempInt * 1024L * 1024L);
+        }
+      }
+      else if(strcmp(defaultString, "maxopenfiles") == 0) {
+        sscanf(buffer, "%s%d", defaultString, &tempInt);
+        if(tempInt < 1) {
+          cerr << "Error in defaults file:  invalid parameter for maxopenfiles:  "
+               << tempInt << endl;
+        } else {
+          maxOpenFiles = tempInt;
+        }
+      }
+      else if(strcmp(defaultString, "previewcells") == 0) {
+        sscanf(buffer, "%s%d", defaultString, &tempInt);
+        if(tempInt < 0) {
+          cerr << "Error in defaults file:  invalid parameter for previewcells:  "
+               << tempInt << endl;
+        } else {
+          previewCells = tempInt;
+        }
+      }
+      else if(strcmp(defaultString, "prefetchframes") == 0) {
+        sscanf(buffer, "%s%d", defaultString, &tempInt);
+        if(tempInt < 0) {
+          cerr << "Error in defaults file:  invalid parameter for prefetchframes:  "
+               << tempInt << endl;
+        } else {
+          prefetchFrames = tempInt;
+        }
+      }
       else if(strcmp(defaultString, "reservesystemcolors") == 0) {
         sscanf(buffer, "%s%d", defaultString, &tempInt);
         PltApp::SetReserveSystemColors(tempInt);
@@ -375,6 +421,51 @@ void AVGlobals::GetDefaults(const string &defaultsFile) {
           PltApp::SetDefaultShowBoxes(false);
         }
       }
+      else if(strcmp(defaultString, "rangeindexfiles") == 0) {
+        sscanf(buffer, "%s%s", defaultString, tempString);
+        if(*tempString == 't' || *tempString == 'T') {
+          bRangeIndexFiles = true;
+        } else if(*tempString == 'f' || *tempString == 'F') {
+          bRangeIndexFiles = false;
+        }
+      }
+      else if(strcmp(defaultString, "volumememmb") == 0) {
+        sscanf(buffer, "%s%d", defaultString, &tempInt);
+        if(tempInt < 0) {
+          cerr << "Error in defaults file:  invalid parameter for volumememmb:  "
+               << tempInt << endl;
+        } else {
+          volumeMemMB = tempInt;
+        }
+      }
+      else if(strcmp(defaultString, "slabcachemb") == 0) {
+        sscanf(buffer, "%s%d", defaultString, &tempInt);
+        if(tempInt < 1) {
+          cerr << "Error in defaults file:  invalid parameter for slabcachemb:  "
+               << tempInt << endl;
+        } else {
+          slabCacheMB = tempInt;
+        }
+      }
+      else if(strcmp(defaultString, "classifycachedir") == 0) {
+        sscanf(buffer, "%s%s", defaultString, tempString);
+        classifyCacheDir = tempString;
+      }
+      else if(strcmp(defaultString, "classifycachemb") == 0) {
+        sscanf(buffer, "%s%d", defaultString, &tempInt);
+        if(tempInt < 0) {
+          cerr << "Error in defaults file:  invalid parameter for classifycachemb:  "
+               << tempInt << endl;
+        } else {
+          classifyCacheMB = tempInt;
+        }
+      }
+      else if(strcmp(defaultString, "mitshm") == 0) {
+        sscanf(buffer, "%s%s", defaultString, tempString);
+        if(*tempString == 'f' || *tempString == 'F') {
+          bUseMITSHM = false;
+        }
+      }
       else if(strcmp(defaultString, "showbody") == 0) {
         sscanf(buffer, "%s%s", defaultString, tempString);
         if(*tempString == 'f' || *tempString == 'F') {
@@ -546,14 +637,30 @@ void PrintUsage(char *exname) {
   cout << "  -v                 verbose." << '\n'; 
   cout << "  -maxpixmapsize n   specify maximum allowed picture size in pixels."
        << '\n';
+  cout << "  -framecachemb n    keep at most n megabytes of animation frames (def is 1024)."
+       << '\n';
+  cout << "  -slabcachemb n     read at most n megabytes per sweep slab (def is 256)."
+       << '\n';
   cout << "  -subdomain _box_   specify subdomain box (on finest level)." << '\n';
   cout << "                     _box_ format:  lox loy loz hix hiy hiz." << '\n';
   cout << "  -skippltlines n    skip n lines at head of the plt file." << '\n'; 
   cout << "  -boxcolor n        set volumetric box color value [0,255]." << '\n'; 
+  cout << "  -previewcells n    render at most n cells while rotating (def is 2097152)." << '\n'; 
 #if(BL_SPACEDIM != 3)
   cout << "  -a                 load files as an animation." << '\n'; 
   cout << "  -aa                load files as an animation with annotations." << '\n'; 
   cout << "  -anc               load files as an animation, dont cache frames." << '\n'; 
+  cout << "  -prefetchframes n  read n frames ahead while animating (def is 2)." << '\n'; 
+  cout << "  -maxopenfiles n    keep at most n animation files open (def is 64)." << '\n'; 
+#endif
+  cout << "  -rangeindex        keep found ranges in plotfile.amrvisranges files." << '\n'; 
+  cout << "  -norangeindex      do not read or write the plotfile.amrvisranges files." << '\n'; 
+  cout << "  -nomitshm          do not use shared memory images (MIT-SHM)." << '\n'; 
+#if(BL_SPACEDIM == 3)
+  cout << "  -classifycache dir keep preclassified volumes in dir for later runs." << '\n'; 
+  cout << "  -classifycachemb n keep at most n MB in the classify cache (def is 16384)." << '\n'; 
+  cout << "  -noclassifycache   do not use the classify cache." << '\n'; 
+  cout << "  -volumememmb n     keep larger volumes in a scratch file (def is 8192)." << '\n'; 
 #endif
   //cout << "  -sleep  n          specify sleep time (for attaching parallel debuggers)." << '\n';
   cout << "  -setvelnames xname yname (zname)   specify velocity names for" << '\n';
@@ -663,6 +770,70 @@ void AVGlobals::ParseCommandLine(int argc, char *argv[]) {
 	maxPictureSize = atoi(argv[i+1]);
       }
       ++i;
+    } else if(strcmp(argv[i], "-framecachemb") == 0) {
+      if(argc-1<i+1 || atoi(argv[i+1]) < 0) {
+        PrintUsage(argv[0]);
+      } else {
+	FrameCache::TheFrameCache().SetMaxBytes(atoi(argv[i+1]) * 1024L * 1024L);
+      }
+      ++i;
+    } else if(strcmp(argv[i], "-rangeindex") == 0) {
+      bRangeIndexFiles = true;
+    } else if(strcmp(argv[i], "-norangeindex") == 0) {
+      bRangeIndexFiles = false;
+    } else if(strcmp(argv[i], "-nomitshm") == 0) {
+      bUseMITSHM = false;
+    } else if(strcmp(argv[i], "-volumememmb") == 0) {
+      if(argc-1<i+1 || atol(argv[i+1]) < 0) {
+        PrintUsage(argv[0]);
+      } else {
+	volumeMemMB = atol(argv[i+1]);
+      }
+      ++i;
+    } else if(strcmp(argv[i], "-slabcachemb") == 0) {
+      if(argc-1<i+1 || atol(argv[i+1]) < 1) {
+        PrintUsage(argv[0]);
+      } else {
+	slabCacheMB = atol(argv[i+1]);
+      }
+      ++i;
+    } else if(strcmp(argv[i], "-classifycache") == 0) {
+      if(argc-1<i+1) {
+        PrintUsage(argv[0]);
+      } else {
+	classifyCacheDir = argv[i+1];
+      }
+      ++i;
+    } else if(strcmp(argv[i], "-classifycachemb") == 0) {
+      if(argc-1<i+1 || atol(argv[i+1]) < 0) {
+        PrintUsage(argv[0]);
+      } else {
+	classifyCacheMB = atol(argv[i+1]);
+      }
+      ++i;
+    } else if(strcmp(argv[i], "-noclassifycache") == 0) {
+      classifyCacheDir.clear();
+    } else if(strcmp(argv[i], "-maxopenfiles") == 0) {
+      if(argc-1<i+1 || atoi(argv[i+1]) < 1) {
+        PrintUsage(argv[0]);
+      } else {
+	maxOpenFiles = atoi(argv[i+1]);
+      }
+      ++i;
+    } else if(strcmp(argv[i], "-previewcells") == 0) {
+      if(argc-1<i+1 || atol(argv[i+1]) < 0) {
+        PrintUsage(argv[0]);
+      } else {
+	previewCells = atol(argv[i+1]);
+      }
+      ++i;
+    } else if(strcmp(argv[i], "-prefetchframes") == 0) {
+      if(argc-1<i+1 || atoi(argv[i+1]) < 0) {
+        PrintUsage(argv[0]);
+      } else {
+	prefetchFrames = atoi(argv[i+1]);
+      }
+      ++i;
     } else if(strcmp(argv[i], "-bw") == 0) {
       if(argc-1<i+1 || atoi(argv[i+1]) < 0) {
         PrintUsage(argv[0]);
@@ -1124,6 +1295,15 @@ bool AVGlobals::IsAnimation()  { return bAnimation; }
 void AVGlobals::SetAnnotated() { bAnnotated = true; }
 bool AVGlobals::IsAnnotated()  { return bAnnotated; }
 bool AVGlobals::CacheAnimFrames()  { return bCacheAnimFrames; }
+int  AVGlobals::PrefetchFrames()   { return prefetchFrames; }
+int  AVGlobals::MaxOpenFiles()     { return maxOpenFiles; }
+bool AVGlobals::RangeIndexFiles()  { return bRangeIndexFiles; }
+bool AVGlobals::UseMITSHM()        { return bUseMITSHM; }
+long AVGlobals::PreviewCells()     { return previewCells; }
+const string &AVGlobals::ClassifyCacheDir() { return classifyCacheDir; }
+long AVGlobals::ClassifyCacheMB()          { return classifyCacheMB; }
+long AVGlobals::VolumeMemMB()      { return volumeMemMB; }
+long AVGlobals::SlabCacheMB()      { return slabCacheMB; }
 
 Box AVGlobals::GetBoxFromCommandLine() { return comlinebox; }
 
@@ -9,11 +9,32 @@ using std::cerr;
 using std::endl;
 
 #include <GraphicsAttributes.H>
+#include <GlobalUtilities.H>
 #include <X11/X.h>
 #include <X11/Xlib.h>
 #include <X11/Intrinsic.h>
 #undef index
 
+#include <cstdlib>
+#ifdef AV_MITSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
+
+
+namespace {
+#ifdef AV_MITSHM
+  // ---- XShmAttach fails with an X error when the server cannot see
+  // ---- our shared memory, such as on a remote display
+  bool bShmAttachFailed(false);
+
+  int ShmAttachErrorHandler(Display *, XErrorEvent *) {
+    bShmAttachFailed = true;
+    return 0;
+  }
+#endif
+}
+
 
 // -------------------------------------------------------------------
 unsigned long buildShift(unsigned long mask) {
@@ -106,6 +127,139 @@ GraphicsAttributes::GraphicsAttributes(Widget topLevel)
   gc = screen->default_gc;
   root = RootWindow(display, DefaultScreen(display));
   bytesPerPixel = CalculateNBP();
+
+  bSharedImages = false;
+  nImagePuts = 0;
+  imageBytesCopied = 0;
+  imageBytesShared = 0;
+#ifdef AV_MITSHM
+  bSharedImages = AVGlobals::UseMITSHM() && XShmQueryExtension(display);
+#endif
+}
+
+
+// -------------------------------------------------------------------
+GraphicsAttributes::~GraphicsAttributes() {
+#ifdef AV_MITSHM
+  while( ! shmSegments.empty()) {
+    DestroyImage(const_cast<XImage *>(shmSegments.begin()->first));
+  }
+#endif
+}
+
+
+// -------------------------------------------------------------------
+XImage *GraphicsAttributes::CreateImage(int width, int height) {
+#ifdef AV_MITSHM
+  if(bSharedImages) {
+    XShmSegmentInfo *shmInfo = new XShmSegmentInfo;
+    XImage *ximage = XShmCreateImage(display, visual, depth, ZPixmap, nullptr,
+                                     shmInfo, width, height);
+    if(ximage != nullptr) {
+      shmInfo->shmid = shmget(IPC_PRIVATE, ximage->bytes_per_line * ximage->height,
+                              IPC_CREAT | 0600);
+      if(shmInfo->shmid >= 0) {
+        shmInfo->shmaddr = static_cast<char *>(shmat(shmInfo->shmid, nullptr, 0));
+        shmInfo->readOnly = False;
+        if(shmInfo->shmaddr != reinterpret_cast<char *>(-1)) {
+          ximage->data = shmInfo->shmaddr;
+          bShmAttachFailed = false;
+          XSync(display, False);
+          XErrorHandler oldHandler = XSetErrorHandler(ShmAttachErrorHandler);
+          XShmAttach(display, shmInfo);
+          XSync(display, False);
+          XSetErrorHandler(oldHandler);
+          // ---- the segment goes away when both sides have detached
+          shmctl(shmInfo->shmid, IPC_RMID, nullptr);
+          if( ! bShmAttachFailed) {
+            shmSegments[ximage] = shmInfo;
+            return ximage;
+          }
+          shmdt(shmInfo->shmaddr);
+        } else {
+          shmctl(shmInfo->shmid, IPC_RMID, nullptr);
+        }
+      }
+      ximage->data = nullptr;
+      XDestroyImage(ximage);
+    }
+    delete shmInfo;
+    // ---- use plain images from now on
+    cerr << "GraphicsAttributes:  MIT-SHM is not usable, using XPutImage." << endl;
+    bSharedImages = false;
+  }
+#endif
+  XImage *ximage = XCreateImage(display, visual, depth, ZPixmap, 0, nullptr,
+                                width, height, BitmapPad(display), 0);
+  if(ximage != nullptr) {
+    ximage->data = static_cast<char *>(malloc(ximage->bytes_per_line * ximage->height));
+    if(ximage->data == nullptr) {
+      XDestroyImage(ximage);
+      ximage = nullptr;
+    }
+  }
+  if(ximage == nullptr) {
+    amrex::Abort("GraphicsAttributes::CreateImage:  could not allocate an image.");
+  }
+  return ximage;
+}
+
+
+// -------------------------------------------------------------------
+void GraphicsAttributes::PutImage(Drawable drawable, GC xgc, XImage *ximage,
+                                  int srcx, int srcy, int dstx, int dsty,
+                                  unsigned int width, unsigned int height)
+{
+  long putBytes(static_cast<long>(width) * height * ximage->bits_per_pixel / 8);
+  ++nImagePuts;
+#ifdef AV_MITSHM
+  if(shmSegments.find(ximage) != shmSegments.end()) {
+    imageBytesShared += putBytes;
+    XShmPutImage(display, drawable, xgc, ximage, srcx, srcy, dstx, dsty,
+                 width, height, False);
+    // ---- the server reads the image after the request, so wait
+    // ---- before the image can be written again
+    XSync(display, False);
+    return;
+  }
+#endif
+  imageBytesCopied += putBytes;
+  XPutImage(display, drawable, xgc, ximage, srcx, srcy, dstx, dsty, width, height);
+}
+
+
+// -------------------------------------------------------------------
+void GraphicsAttributes::PrintImageStats(ostream &os) const {
+  os << "GraphicsAttributes:  " << nImagePuts << " image puts, "
+     << imageBytesCopied << " bytes copied, " << imageBytesShared
+     << " bytes shared" << (bSharedImages ? " (MIT-SHM)" : "") << endl;
+  if(nImagePuts > 0) {
+    os << "GraphicsAttributes:  "
+       << (imageBytesCopied + imageBytesShared) / nImagePuts
+       << " bytes per put, "
+       << imageBytesCopied / nImagePuts << " copied through the connection" << endl;
+  }
+}
+
+
+// -------------------------------------------------------------------
+void GraphicsAttributes::DestroyImage(XImage *ximage) {
+  if(ximage == nullptr) {
+    return;
+  }
+#ifdef AV_MITSHM
+  std::map<const XImage *, XShmSegmentInfo *>::iterator it(shmSegments.find(ximage));
+  if(it != shmSegments.end()) {
+    XShmSegmentInfo *shmInfo = it->second;
+    shmSegments.erase(it);
+    XShmDetach(display, shmInfo);
+    XSync(display, False);
+    shmdt(shmInfo->shmaddr);
+    delete shmInfo;
+    ximage->data = nullptr;  // ---- so XDestroyImage does not free it
+  }
+#endif
+  XDestroyImage(ximage);
 }
 
 
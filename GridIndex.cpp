@@ -0,0 +1,51 @@
+// ---------------------------------------------------------------
+// GridIndex.cpp
+// ---------------------------------------------------------------
+#include <GridIndex.H>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+using std::endl;
+
+using namespace amrex;
+
+std::atomic<long> GridIndex::nQueries(0);
+std::atomic<long> GridIndex::nGridsFound(0);
+
+
+// -------------------------------------------------------------------
+void GridIndex::Intersecting(const BoxArray &ba, const Box &onBox,
+                             Vector<int> &gridIndices)
+{
+  gridIndices.clear();
+  ++nQueries;
+  if(ba.empty() || ! onBox.ok()) {
+    return;
+  }
+  std::vector< std::pair<int, Box> > isects;
+  ba.intersections(onBox, isects);
+  gridIndices.reserve(isects.size());
+  for(const auto &isect : isects) {
+    gridIndices.push_back(isect.first);
+  }
+  // ---- the hash returns the grids by bin, callers expect grid order
+  std::sort(gridIndices.begin(), gridIndices.end());
+  nGridsFound += gridIndices.size();
+}
+
+
+// -------------------------------------------------------------------
+void GridIndex::PrintStats(ostream &os, long queriessince, long gridssince,
+                           int nframes)
+{
+  long nq(nQueries - queriessince);
+  os << "GridIndex:  " << nq << " grid queries found "
+     << nGridsFound - gridssince << " grids";
+  if(nframes > 0) {
+    os << ", " << static_cast<double>(nq) / nframes << " queries per frame";
+  }
+  os << endl;
+}
+// ---------------------------------------------------------------
+// ---------------------------------------------------------------
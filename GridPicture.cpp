@@ -72,7 +72,7 @@ void  GridPicture::ChangeScale(int newScale, int picSizeH, int picSizeV) {
 
 
 // -------------------------------------------------------------------
-int GridPicture::HPositionInPicture() {
+int GridPicture::HPositionInPicture() const {
   int endLoc;
   if(sliceDir == Amrvis::ZDIR) {
     endLoc = imageBox.smallEnd()[Amrvis::XDIR];
@@ -86,7 +86,7 @@ int GridPicture::HPositionInPicture() {
 
 
 // -------------------------------------------------------------------
-int GridPicture::VPositionInPicture() {
+int GridPicture::VPositionInPicture() const {
   int endLoc, nodeAdjustment;
   if(sliceDir == Amrvis::ZDIR) {
 #if (BL_SPACEDIM == 1)
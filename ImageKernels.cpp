@@ -0,0 +1,392 @@
+// ---------------------------------------------------------------
+// ImageKernels.cpp
+// ---------------------------------------------------------------
+#include <ImageKernels.H>
+#include <Palette.H>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+  // ---- below this many cells the threading overhead is not worth it
+  const long minParallelCells(1 << 16);
+
+
+  // ---- segment orders for merging:  by line, then by start
+  bool HorizontalLess(const XSegment &a, const XSegment &b) {
+    return a.y1 < b.y1 || (a.y1 == b.y1 && a.x1 < b.x1);
+  }
+  bool VerticalLess(const XSegment &a, const XSegment &b) {
+    return a.x1 < b.x1 || (a.x1 == b.x1 && a.y1 < b.y1);
+  }
+  bool SegmentLess(const XSegment &a, const XSegment &b) {
+    if(a.x1 != b.x1) { return a.x1 < b.x1; }
+    if(a.y1 != b.y1) { return a.y1 < b.y1; }
+    if(a.x2 != b.x2) { return a.x2 < b.x2; }
+    return a.y2 < b.y2;
+  }
+  bool SegmentEqual(const XSegment &a, const XSegment &b) {
+    return a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2;
+  }
+
+
+  // -------------------------------------------------------------------
+  // ---- call rowFunc(j) for each row.  inside an existing parallel
+  // ---- region (a per-level task, for example) the rows become tasks
+  // ---- for the whole team instead of a serialized nested region.
+  template<typename F>
+  void ForEachRow(int nRows, bool bThreaded, F rowFunc) {
+#ifdef _OPENMP
+    if(bThreaded && omp_in_parallel()) {
+#pragma omp taskloop
+      for(int j = 0; j < nRows; ++j) {
+        rowFunc(j);
+      }
+    } else {
+#pragma omp parallel for if(bThreaded)
+      for(int j = 0; j < nRows; ++j) {
+        rowFunc(j);
+      }
+    }
+#else
+    (void) bThreaded;
+    for(int j = 0; j < nRows; ++j) {
+      rowFunc(j);
+    }
+#endif
+  }
+
+
+  // -------------------------------------------------------------------
+  // ---- one image row.  the clip tests are selects, not branches, so
+  // ---- the compiler can vectorize the whole row.
+  template<bool bMask, bool bNegToBG>
+  inline void QuantizeRow(const Real * __restrict__ drow,
+                          const Real * __restrict__ vfrow,
+                          unsigned char * __restrict__ irow, int nh,
+                          Real gMin, Real gMax, Real oneOverGDiff, Real slotScale,
+                          int pStart, int pEnd, Real vfeps, int bodyColor)
+  {
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+    for(int i = 0; i < nh; ++i) {
+      Real d(drow[i]);
+      if(bNegToBG) {
+        d = (d < 0.0) ? -2.0 : d;
+      }
+      Real dClip(std::min(std::max(gMin, d), gMax));
+      int index((int) (((dClip - gMin) * oneOverGDiff) * slotScale) + pStart);
+      index = (d > gMax) ? pEnd   : index;
+      index = (d < gMin) ? pStart : index;
+      if(bMask) {
+        index = (vfrow[i] < vfeps) ? bodyColor : index;
+      }
+      irow[i] = (unsigned char) index;
+    }
+  }
+
+
+  // -------------------------------------------------------------------
+  template<bool bMask, bool bNegToBG>
+  void QuantizeRows(const Real *dataPoint, const Real *vfDataPoint,
+                    unsigned char *imagedata, int datasizeh, int datasizev,
+                    Real globalMin, Real globalMax, Real slotScale,
+                    int paletteStart, int paletteEnd,
+                    Real vfeps, int bodyColor)
+  {
+    Real oneOverGDiff;
+    if((globalMax - globalMin) < FLT_MIN) {
+      oneOverGDiff = 0.0;
+    } else {
+      oneOverGDiff = 1.0 / (globalMax - globalMin);
+    }
+    long nCells(static_cast<long>(datasizeh) * datasizev);
+
+    ForEachRow(datasizev, nCells > minParallelCells, [&] (int j) {
+      long dRowStart(static_cast<long>(datasizev - j - 1) * datasizeh);
+      long iRowStart(static_cast<long>(j) * datasizeh);
+      QuantizeRow<bMask, bNegToBG>(dataPoint + dRowStart,
+                                   bMask ? vfDataPoint + dRowStart : nullptr,
+                                   imagedata + iRowStart, datasizeh,
+                                   globalMin, globalMax, oneOverGDiff, slotScale,
+                                   paletteStart, paletteEnd, vfeps, bodyColor);
+    });
+  }
+
+
+  // -------------------------------------------------------------------
+  // ---- lay out pixel value p in the image's byte order
+  template<typename PixelT>
+  PixelT EncodePixel(Pixel p, int byteOrder) {
+    unsigned char bytes[sizeof(PixelT)];
+    for(int b = 0; b < static_cast<int>(sizeof(PixelT)); ++b) {
+      int shift(byteOrder == LSBFirst ? b : static_cast<int>(sizeof(PixelT)) - 1 - b);
+      bytes[b] = static_cast<unsigned char>((p >> (8 * shift)) & 0xff);
+    }
+    PixelT encoded;
+    std::memcpy(&encoded, bytes, sizeof(PixelT));
+    return encoded;
+  }
+
+
+  // -------------------------------------------------------------------
+  template<typename PixelT>
+  void WriteScaledRows(XImage *ximage, const unsigned char *imagedata,
+                       int datasizeh, int datasizev, int scale,
+                       const Palette &palette, bool bDim,
+                       const unsigned char *remaptable)
+  {
+    PixelT pixelTable[256];
+    for(int idx = 0; idx < 256; ++idx) {
+      int pidx(remaptable != nullptr ? remaptable[idx] : idx);
+      Pixel p(bDim ? palette.makePixelDim(pidx) : palette.makePixel(pidx));
+      pixelTable[idx] = EncodePixel<PixelT>(p, ximage->byte_order);
+    }
+
+    int widthpad(ximage->width);
+    int imagesizev(ximage->height);
+    int bytesPerLine(ximage->bytes_per_line);
+    char *imageBase(ximage->data);
+    int nSourceRows(std::min(datasizev, (imagesizev + scale - 1) / scale));
+    long nPixels(static_cast<long>(widthpad) * imagesizev);
+
+    ForEachRow(nSourceRows, nPixels > minParallelCells, [&] (int jd) {
+      int jFirst(jd * scale);
+      PixelT *row = reinterpret_cast<PixelT *>(imageBase +
+                                   static_cast<long>(jFirst) * bytesPerLine);
+      const unsigned char *srcRow = imagedata + static_cast<long>(jd) * datasizeh;
+      int i(0);
+      for(int id = 0; id < datasizeh && i < widthpad; ++id) {
+        PixelT p(pixelTable[srcRow[id]]);
+        for(int s = 0; s < scale && i < widthpad; ++s) {
+          row[i++] = p;
+        }
+      }
+      PixelT pLast(pixelTable[srcRow[datasizeh - 1]]);  // ---- the pad
+      for( ; i < widthpad; ++i) {
+        row[i] = pLast;
+      }
+      for(int j = jFirst + 1; j < std::min(jFirst + scale, imagesizev); ++j) {
+        std::memcpy(imageBase + static_cast<long>(j) * bytesPerLine, row,
+                    widthpad * sizeof(PixelT));
+      }
+    });
+  }
+
+}  // end anonymous namespace
+
+
+// -------------------------------------------------------------------
+void AVImage::QuantizeToIndex(const Real *dataPoint, unsigned char *imagedata,
+                              int datasizeh, int datasizev,
+                              Real globalMin, Real globalMax, Real slotScale,
+                              int paletteStart, int paletteEnd,
+                              bool bNegativeToBackground)
+{
+  if(bNegativeToBackground) {
+    QuantizeRows<false, true>(dataPoint, nullptr, imagedata, datasizeh, datasizev,
+                              globalMin, globalMax, slotScale,
+                              paletteStart, paletteEnd, 0.0, 0);
+  } else {
+    QuantizeRows<false, false>(dataPoint, nullptr, imagedata, datasizeh, datasizev,
+                               globalMin, globalMax, slotScale,
+                               paletteStart, paletteEnd, 0.0, 0);
+  }
+}
+
+
+// -------------------------------------------------------------------
+void AVImage::QuantizeToIndexMasked(const Real *dataPoint, unsigned char *imagedata,
+                                    int datasizeh, int datasizev,
+                                    Real globalMin, Real globalMax, Real slotScale,
+                                    int paletteStart, int paletteEnd,
+                                    const Real *vfDataPoint, Real vfeps,
+                                    int bodyColor)
+{
+  QuantizeRows<true, false>(dataPoint, vfDataPoint, imagedata, datasizeh, datasizev,
+                            globalMin, globalMax, slotScale,
+                            paletteStart, paletteEnd, vfeps, bodyColor);
+}
+
+
+// -------------------------------------------------------------------
+void AVImage::WriteScaledImage(XImage *ximage, const unsigned char *imagedata,
+                               int datasizeh, int datasizev, int scale,
+                               const Palette &palette, bool bDim,
+                               const unsigned char *remaptable)
+{
+  if(ximage->format == ZPixmap) {
+    switch(ximage->bits_per_pixel) {
+      case 8:
+        WriteScaledRows<uint8_t>(ximage, imagedata, datasizeh, datasizev,
+                                 scale, palette, bDim, remaptable);
+        return;
+      case 16:
+        WriteScaledRows<uint16_t>(ximage, imagedata, datasizeh, datasizev,
+                                  scale, palette, bDim, remaptable);
+        return;
+      case 32:
+        WriteScaledRows<uint32_t>(ximage, imagedata, datasizeh, datasizev,
+                                  scale, palette, bDim, remaptable);
+        return;
+      default:
+        break;
+    }
+  }
+
+  // ---- any other format
+  int lastIndex(datasizeh * datasizev - 1);
+  for(int j(0); j < ximage->height; ++j) {
+    int jtmp(datasizeh * (j / scale));
+    for(int i(0); i < ximage->width; ++i) {
+      int itmp(i / scale);
+      unsigned char imm1(imagedata[std::min(itmp + jtmp, lastIndex)]);
+      if(remaptable != nullptr) {
+        imm1 = remaptable[imm1];
+      }
+      XPutPixel(ximage, i, j, bDim ? palette.makePixelDim(imm1)
+                                   : palette.makePixel(imm1));
+    }
+  }
+}
+
+
+// -------------------------------------------------------------------
+void AVImage::RunLengthEncode(const unsigned char *data, long n,
+                              amrex::Vector<unsigned char> &encoded)
+{
+  encoded.clear();
+  encoded.reserve(n + (n + 127) / 128);
+  long i(0);
+  while(i < n) {
+    long run(1);
+    while(i + run < n && run < 128 && data[i + run] == data[i]) {
+      ++run;
+    }
+    if(run >= 3) {
+      encoded.push_back(static_cast<unsigned char>(257 - run));
+      encoded.push_back(data[i]);
+      i += run;
+    } else {  // ---- literals up to the next run of three
+      long start(i);
+      while(i < n && i - start < 128) {
+        if(i + 2 < n && data[i] == data[i + 1] && data[i] == data[i + 2]) {
+          break;
+        }
+        ++i;
+      }
+      encoded.push_back(static_cast<unsigned char>(i - start - 1));
+      encoded.insert(encoded.end(), data + start, data + i);
+    }
+  }
+}
+
+
+// -------------------------------------------------------------------
+void AVImage::RunLengthDecode(const unsigned char *encoded, long nencoded,
+                              unsigned char *data, long n)
+{
+  long iIn(0), iOut(0);
+  while(iIn < nencoded && iOut < n) {
+    int c(encoded[iIn++]);
+    if(c < 128) {
+      long len(std::min(static_cast<long>(c) + 1, n - iOut));
+      std::memcpy(data + iOut, encoded + iIn, len);
+      iIn  += c + 1;
+      iOut += len;
+    } else if(c > 128) {
+      long len(std::min(static_cast<long>(257 - c), n - iOut));
+      std::memset(data + iOut, encoded[iIn++], len);
+      iOut += len;
+    }
+  }
+}
+
+
+// -------------------------------------------------------------------
+void AVImage::RectangleOutlines(const XRectangle *rects, int nrects,
+                                int width, int height,
+                                amrex::Vector<XSegment> &segments)
+{
+  segments.clear();
+  segments.reserve(4 * nrects);
+  for(int i(0); i < nrects; ++i) {
+    int xlo(rects[i].x), ylo(rects[i].y);
+    int xhi(xlo + rects[i].width), yhi(ylo + rects[i].height);
+    if(xhi < 0 || yhi < 0 || xlo >= width || ylo >= height) {
+      continue;
+    }
+    XSegment seg;
+    seg.x1 = xlo; seg.y1 = ylo; seg.x2 = xhi; seg.y2 = ylo;
+    segments.push_back(seg);
+    seg.y1 = yhi; seg.y2 = yhi;
+    segments.push_back(seg);
+    seg.x1 = xlo; seg.y1 = ylo; seg.x2 = xlo; seg.y2 = yhi;
+    segments.push_back(seg);
+    seg.x1 = xhi; seg.x2 = xhi;
+    segments.push_back(seg);
+  }
+  MergeSegments(segments);
+}
+
+
+// -------------------------------------------------------------------
+void AVImage::MergeSegments(amrex::Vector<XSegment> &segments) {
+  amrex::Vector<XSegment> hSegs, vSegs, oSegs;
+  for(int i(0); i < segments.size(); ++i) {
+    XSegment seg(segments[i]);
+    if(seg.y1 == seg.y2) {
+      if(seg.x1 > seg.x2) {
+        std::swap(seg.x1, seg.x2);
+      }
+      hSegs.push_back(seg);
+    } else if(seg.x1 == seg.x2) {
+      if(seg.y1 > seg.y2) {
+        std::swap(seg.y1, seg.y2);
+      }
+      vSegs.push_back(seg);
+    } else {
+      if(seg.x1 > seg.x2 || (seg.x1 == seg.x2 && seg.y1 > seg.y2)) {
+        std::swap(seg.x1, seg.x2);
+        std::swap(seg.y1, seg.y2);
+      }
+      oSegs.push_back(seg);
+    }
+  }
+
+  segments.clear();
+  std::sort(hSegs.begin(), hSegs.end(), HorizontalLess);
+  for(int i(0); i < hSegs.size(); ++i) {
+    if( ! segments.empty() && segments.back().y1 == hSegs[i].y1 &&
+       hSegs[i].x1 <= segments.back().x2)
+    {
+      segments.back().x2 = std::max(segments.back().x2, hSegs[i].x2);
+    } else {
+      segments.push_back(hSegs[i]);
+    }
+  }
+  long nHorizontal(segments.size());
+  std::sort(vSegs.begin(), vSegs.end(), VerticalLess);
+  for(int i(0); i < vSegs.size(); ++i) {
+    if(segments.size() > nHorizontal && segments.back().x1 == vSegs[i].x1 &&
+       vSegs[i].y1 <= segments.back().y2)
+    {
+      segments.back().y2 = std::max(segments.back().y2, vSegs[i].y2);
+    } else {
+      segments.push_back(vSegs[i]);
+    }
+  }
+  std::sort(oSegs.begin(), oSegs.end(), SegmentLess);
+  oSegs.erase(std::unique(oSegs.begin(), oSegs.end(), SegmentEqual), oSegs.end());
+  segments.insert(segments.end(), oSegs.begin(), oSegs.end());
+}
+// ---------------------------------------------------------------
+// ---------------------------------------------------------------
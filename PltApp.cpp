@@ -35,11 +35,14 @@
 #include <ProjectionPicture.H>
 #include <XYPlotWin.H>
 #include <MessageArea.H>
+#include <FrameCache.H>
+#include <RangeIndex.H>
 
 #if defined(BL_PARALLELVOLUMERENDER)
 #include <PVolRender.H>
 #endif
 
+#include <algorithm>
 #include <cctype>
 #include <sstream>
 #include <cmath>
@@ -82,6 +85,8 @@ PltApp::~PltApp() {
   if(animating2d) {
     StopAnimation();
   }
+  StopPrefetch();
+  FrameCache::TheFrameCache().EraseOwner(this);
   for(np = 0; np != Amrvis::NPLANES; ++np) {
     delete amrPicturePtrArray[np];
   }
@@ -115,6 +120,12 @@ PltApp::PltApp(XtAppContext app, Widget w, const string &filename,
 {
   dataServicesPtr = dataservicesptr;
   currentFrame = 0;
+  pictureFrame = currentFrame;
+  for(int i(0); i < dataServicesPtr.size(); ++i) {
+    if(dataServicesPtr[i] != nullptr) {
+      openFrames.push_back(i);
+    }
+  }
   fileName = filename;
 
 #if defined(BL_VOLUMERENDER) || defined(BL_PARALLELVOLUMERENDER)
@@ -355,9 +366,25 @@ PltApp::PltApp(XtAppContext app, Widget w, const string &filename,
   string asCDer(pltAppState->CurrentDerived());
   int fineLevel(amrData.FinestLevel());
   const Vector<Box> &onBox(amrData.ProbDomain());
+  RangeIndex::ReadIndices(fileNames);
+  // ---- only the first frame and the frames already in their range
+  // ---- index are scanned here, the others are found when they are
+  // ---- shown or prefetched.  see FindFrameRange.
   for(int iFrame(0); iFrame < animFrames; ++iFrame) {
     Real rFileMin, rFileMax;
 
+    RangeIndex &rangeIndex = RangeIndex::ForFile(fileNames[iFrame]);
+    bool bIndexed(iFrame == currentFrame);
+    for(int lev(coarseLevel); ! bIndexed && lev <= fineLevel; ++lev) {
+      bool bIndexValid;
+      if( ! rangeIndex.Find(asCDer, lev, onBox[lev], rFileMin, rFileMax, bIndexValid)) {
+        break;
+      }
+      bIndexed = (lev == fineLevel);
+    }
+    if( ! bIndexed) {
+      continue;
+    }
     FindAndSetMinMax(Amrvis::FILEGLOBALMINMAX, iFrame, asCDer, iCDerNum,
 		     onBox, coarseLevel, fineLevel, false);  // dont reset if set
     pltAppState->GetMinMax(Amrvis::FILEGLOBALMINMAX, iFrame, iCDerNum,
@@ -460,7 +487,12 @@ PltApp::PltApp(XtAppContext app, Widget w, const Box &region,
     lightingFilename(sPltParent->lightingFilename)
 {
   dataServicesPtr = sPltParent->dataServicesPtr;
+  openFrames = sPltParent->openFrames;
+  for(std::list<int>::iterator it = openFrames.begin(); it != openFrames.end(); ++it) {
+    dataServicesPtr[*it]->IncrementNumberOfUsers();
+  }
   currentFrame = sPltParent->currentFrame;
+  pictureFrame = currentFrame;
   fileName = filename;
   fileNames = sPltParent->fileNames;
   palFilename = palfile;
@@ -672,8 +704,8 @@ PltApp::PltApp(XtAppContext app, Widget w, const Box &region,
   for(int iFrame(0); iFrame < animFrames; ++iFrame) {
     // GLOBALMINMAX is already set to parent's values
     // USERMINMAX is already set to parent's values
-    // FILEGLOBALMINMAX is already set to parent's values
-    // FILEUSERMINMAX is already set to parent's values
+    // FILEGLOBALMINMAX is already set to parent's values where found
+    // FILEUSERMINMAX is already set to parent's values where found
     // these do not change for a subregion
 
     // set FILESUBREGIONMINMAX
@@ -778,11 +810,10 @@ void PltApp::PltAppInit(bool bSubVolume) {
   endY = 0;
 
   animationIId = 0;
+  prefetchWPId = 0;
+  prefetchCount = 0;
   frameSpeed = 300;
 
-  readyFrames.resize(animFrames, false);
-  frameBuffer.resize(animFrames);
-
   selectionBox.convert(amrData.ProbDomain()[0].type());
   selectionBox.setSmall(IntVect::TheZeroVector());
   selectionBox.setBig(IntVect::TheZeroVector());
@@ -1156,6 +1187,11 @@ void PltApp::PltAppInit(bool bSubVolume) {
   if(lightingModel == false) {
     wCurrentRenderMode = wid;
   }
+  XtVaCreateManagedWidget(NULL, xmSeparatorGadgetClass, wCascade, NULL);
+  wid = XtVaCreateManagedWidget("AMR Ray Cast", xmToggleButtonGadgetClass,
+				wCascade, XmNset, false, NULL);
+  AddStaticCallback(wid, XmNvalueChangedCallback,
+		    &PltApp::DoRenderModeMenu, (XtPointer) 2);
   
   wCascade = XmCreatePulldownMenu(wMenuPulldown, const_cast<char *>("classifymenu"), NULL, 0);
   XtVaCreateManagedWidget("Classify", xmCascadeButtonWidgetClass, wMenuPulldown,
@@ -1739,18 +1775,27 @@ void PltApp::FindAndSetMinMax(const Amrvis::MinMaxRangeType mmrangetype,
   if(isSet == false || resetIfSet) {  // find and set the mins and maxes
     rMin =  std::numeric_limits<Real>::max();
     rMax = -std::numeric_limits<Real>::max();
+    // ---- ranges already found in this or an earlier session are
+    // ---- read from the file's range index instead of the data
+    RangeIndex &rangeIndex = RangeIndex::ForFile(fileNames[framenumber]);
     for(int lev(coarselevel); lev <= finelevel; ++lev) {
       bool minMaxValid(false);
-      DataServices::Dispatch(DataServices::MinMaxRequest,
-                             dataServicesPtr[framenumber],
-                             (void *) &(onBox[lev]),
-                             (void *) &(currentderived),
-                             lev, &levMin, &levMax, &minMaxValid);
+      if( ! rangeIndex.Find(currentderived, lev, onBox[lev],
+                            levMin, levMax, minMaxValid))
+      {
+        DataServices *dsp = FrameDataServices(framenumber);
+        GridRangeSummary::ForData(dsp, currentderived).MinMax(dsp, onBox[lev], lev,
+                                                      levMin, levMax, minMaxValid);
+        bool bWholeDomain(onBox[lev] == dsp->AmrDataRef().ProbDomain()[lev]);
+        rangeIndex.Insert(currentderived, lev, onBox[lev], levMin, levMax, minMaxValid,
+                          bWholeDomain);
+      }
       if(minMaxValid) {
         rMin = min(rMin, levMin);
         rMax = max(rMax, levMax);
       }
     }
+    rangeIndex.Write();
     if(bTimeline) {
       rMin = timelineMin;
       rMax = timelineMax;
@@ -2017,8 +2062,6 @@ void PltApp::ChangeDerived(Widget w, XtPointer client_data, XtPointer) {
     pltPaletteptr->RedrawPalette();
   }
 
-  int maxDrawnLevel = pltAppState->MaxDrawnLevel();
-
   const AmrData &amrData = dataServicesPtr[currentFrame]->AmrDataRef();
 
   // possibly set all six minmax types here
@@ -2035,6 +2078,13 @@ void PltApp::ChangeDerived(Widget w, XtPointer client_data, XtPointer) {
   rSubregionMin =  std::numeric_limits<Real>::max();
   rSubregionMax = -std::numeric_limits<Real>::max();
   const string asCDer(pltAppState->CurrentDerived());
+  if(animating2d) {
+    string outbuf("Finding global min & max values for ");
+    outbuf += asCDer;
+    outbuf += "...\n";
+    PrintMessage(const_cast<char *>(outbuf.c_str()));
+  }
+  double dRangeTime(ParallelDescriptor::second());
   for(int iFrame(0); iFrame < animFrames; ++iFrame) {
     // set FILEGLOBALMINMAX  dont reset if already set
     FindAndSetMinMax(Amrvis::FILEGLOBALMINMAX, iFrame, asCDer, iCDerNum, onBox,
@@ -2078,8 +2128,10 @@ void PltApp::ChangeDerived(Widget w, XtPointer client_data, XtPointer) {
 			     rSubregionMin, rSubregionMax);
     }
   }
+  dRangeTime = ParallelDescriptor::second() - dRangeTime;
   if(AVGlobals::Verbose()) {
-    cout << "_in PltApp::ChangeDerived" << endl;
+    cout << "_in PltApp::ChangeDerived:  ranges for " << animFrames
+         << " frames found in " << dRangeTime << " s" << endl;
     pltAppState->PrintSetMap();
     cout << endl;
   }
@@ -2098,45 +2150,6 @@ void PltApp::ChangeDerived(Widget w, XtPointer client_data, XtPointer) {
   if(animating2d) {
     ResetAnimation();
     DirtyFrames();
-    if(UsingFileRange(currentRangeType)) {
-      Real dataMin, dataMax;
-      int sCoarseLevel(0);
-      int sFineLevel(maxDrawnLevel);
-      for(int lev(sCoarseLevel); lev <= sFineLevel; ++lev) {
-	bool minMaxValid(false);
-	DataServices::Dispatch(DataServices::MinMaxRequest,
-			       dataServicesPtr[currentFrame],
-			       (void *) &(amrData.ProbDomain()[lev]),
-			       (void *) &(pltAppState->CurrentDerived()),
-			       lev, &dataMin, &dataMax, &minMaxValid);
-	if( ! minMaxValid) {
-	  continue;
-	}
-      }
-    } else if(strcmp(pltAppState->CurrentDerived().c_str(),"vfrac") == 0) {
-    } else {
-      string outbuf("Finding global min & max values for ");
-      outbuf += pltAppState->CurrentDerived();
-      outbuf += "...\n";
-      PrintMessage(const_cast<char *>(outbuf.c_str()));
-      
-      Real dataMin, dataMax;
-      int sCoarseLevel(0);
-      int sFineLevel(maxDrawnLevel);
-      for(int iFrame(0); iFrame < animFrames; ++iFrame) {
-	for(int lev(sCoarseLevel); lev <= sFineLevel; ++lev) {
-	  bool minMaxValid(false);
-	  DataServices::Dispatch(DataServices::MinMaxRequest,
-				 dataServicesPtr[iFrame],
-				 (void *) &(amrData.ProbDomain()[lev]),
-				 (void *) &(pltAppState->CurrentDerived()),
-				 lev, &dataMin, &dataMax, &minMaxValid);
-	  if( ! minMaxValid) {
-	    continue;
-	  }
-	}
-      }
-    } 
   }  // end if(animating2d)
   
   strcpy(buffer, pltAppState->CurrentDerived().c_str());
@@ -3442,7 +3455,9 @@ void PltApp::DoOpenPalFile(Widget w, XtPointer, XtPointer call_data) {
   }
   if(animating2d) {
     ResetAnimation();
-    DirtyFrames(); 
+    // ---- the index frames are colored when shown, so they take the new palette
+    paletteDrawn = false;
+    FrameCache::TheFrameCache().EraseOwnerImageFrames(this);
   }
 }
 
@@ -4421,11 +4436,16 @@ void PltApp::DoExposePalette(Widget, XtPointer, XtPointer) {
 
 
 // -------------------------------------------------------------------
-void PltApp::PADoExposePicture(Widget /*w*/, XtPointer client_data, XtPointer) {
+void PltApp::PADoExposePicture(Widget /*w*/, XtPointer client_data, XtPointer call_data) {
   unsigned long np = (unsigned long) client_data;
+  XEvent *event = (XEvent *) call_data;
 //cout << "==%%%%%%%%%%%%=== _in PADoExposePicture:  currentFrame = " << currentFrame << endl;
   
-  amrPicturePtrArray[np]->DoExposePicture();
+  if(event != nullptr && event->type == Expose) {
+    amrPicturePtrArray[np]->DoExposePicture(event->xexpose);
+  } else {
+    amrPicturePtrArray[np]->DoExposePicture();
+  }
   // draw bounding box
   /*
   int isX = amrPicturePtrArray[np]->ImageSizeH();
@@ -4811,6 +4831,7 @@ void PltApp::ResetAnimation() {
 					      pltPaletteptr);
     AddStaticEventHandler(wPlotPlane[Amrvis::ZPLANE], ExposureMask,
 			  &PltApp::PADoExposePicture, (XtPointer) Amrvis::ZPLANE);
+    pictureFrame = currentFrame;
     interfaceReady = true;
 #endif
   }
@@ -4823,6 +4844,7 @@ void PltApp::StopAnimation() {
     XtRemoveTimeOut(animationIId);
     animationIId = 0;
   }
+  StopPrefetch();
 #if (BL_SPACEDIM != 3)
   for(int dim(0); dim < BL_SPACEDIM; ++dim) {
     if(XYplotwin[dim]) {
@@ -4845,18 +4867,186 @@ void PltApp::Animate(Amrvis::AnimDirection direction) {
     }
   }
 #endif
+  StartPrefetch();
+}
+
+
+// -------------------------------------------------------------------
+// ---- make the next frames in the animation direction while the
+// ---- current one is on the screen.  the plot file reads are not
+// ---- thread safe, so this runs as a work procedure between events,
+// ---- one frame per call.  StopAnimation cancels it, and Animate
+// ---- restarts it when the direction changes.
+void PltApp::StartPrefetch() {
+  StopPrefetch();
+#if (BL_SPACEDIM != 3)
+  if(AVGlobals::PrefetchFrames() > 0 && AVGlobals::CacheAnimFrames() &&
+     ! datasetShowing && ! UsingFileRange(currentRangeType))
+  {
+    prefetchCount = 0;
+    prefetchWPId = XtAppAddWorkProc(appContext,
+                                    (XtWorkProc) &PltApp::StaticPrefetch,
+                                    (XtPointer) this);
+  }
+#endif
+}
+
+
+// -------------------------------------------------------------------
+void PltApp::StopPrefetch() {
+  if(prefetchWPId) {
+    XtRemoveWorkProc(prefetchWPId);
+    prefetchWPId = 0;
+  }
+}
+
+
+// -------------------------------------------------------------------
+// ---- make the next frame ahead that is not cached.  returns true
+// ---- when there is nothing left to prefetch.
+bool PltApp::PrefetchNextFrame() {
+  FrameCache &frameCache = FrameCache::TheFrameCache();
+  int depth(std::min(AVGlobals::PrefetchFrames(), animFrames - 1));
+  const CachedFrame *shownFrame = CurrentFrame();
+  if(shownFrame != nullptr) {  // ---- dont evict the frames just made
+    depth = std::min(depth, frameCache.FramesInBudget(shownFrame->Bytes()) - 1);
+  }
+  while(prefetchCount < depth) {
+    ++prefetchCount;
+    int iStep(animDirection == Amrvis::ANIMPOSDIR ? prefetchCount : -prefetchCount);
+    int iFrame(((currentFrame + iStep) % animFrames + animFrames) % animFrames);
+    if(frameCache.Peek(this, iFrame) != nullptr) {
+      continue;
+    }
+    if(FindFrameRange(iFrame)) {  // ---- redraw with the wider range, then start over
+      DirtyFrames();
+      ShowFrame();
+      prefetchCount = 0;
+      return false;
+    }
+    double time0(ParallelDescriptor::second());
+    CachedFrame *cframe =
+        amrPicturePtrArray[Amrvis::ZPLANE]->MakeFileFrame(FrameDataServices(iFrame));
+    if(cframe == nullptr) {  // ---- this picture is made when shown
+      return true;
+    }
+    frameCache.Insert(this, iFrame, cframe);
+    if(AVGlobals::Verbose()) {
+      cout << "_in PrefetchNextFrame:  frame " << iFrame << " time = "
+           << ParallelDescriptor::second() - time0 << " s" << endl;
+    }
+    return false;
+  }
+  return true;
 }
 
 
 // -------------------------------------------------------------------
 void PltApp::DirtyFrames() {
   paletteDrawn = false;
+  FrameCache::TheFrameCache().EraseOwner(this);
+}
+
+
+// -------------------------------------------------------------------
+// ---- the DataServices for frame iFrame.  animation files are opened
+// ---- when they are first needed, and the least recently used ones
+// ---- past AVGlobals::MaxOpenFiles() are closed again.  the frame on
+// ---- the screen and the frame the pictures were made from stay open.
+DataServices *PltApp::FrameDataServices(int iFrame) {
+  if(dataServicesPtr[iFrame] == nullptr) {
+    double time0(ParallelDescriptor::second());
+    DataServices *dsp = new DataServices();
+    dsp->Init(fileNames[iFrame], AVGlobals::GetDefaultFileType());
+    DataServices::Dispatch(DataServices::NewRequest, dsp, NULL);
+    if( ! dsp->AmrDataOk()) {
+      amrex::Abort("Error:  could not open animation file " + fileNames[iFrame]);
+    }
+    dsp->IncrementNumberOfUsers();
+    dataServicesPtr[iFrame] = dsp;
+    if(AVGlobals::Verbose()) {
+      cout << "_in FrameDataServices:  opened " << fileNames[iFrame] << " in "
+           << ParallelDescriptor::second() - time0 << " s" << endl;
+    }
+  }
+  openFrames.remove(iFrame);
+  openFrames.push_front(iFrame);
+
+  std::list<int>::iterator it(openFrames.end());
+  while(static_cast<int>(openFrames.size()) > AVGlobals::MaxOpenFiles() &&
+        it != openFrames.begin())
+  {
+    --it;
+    int iClose(*it);
+    if(iClose == iFrame || iClose == currentFrame || iClose == pictureFrame) {
+      continue;
+    }
+    it = openFrames.erase(it);
+    dataServicesPtr[iClose]->DecrementNumberOfUsers();
+    DataServices::Dispatch(DataServices::DeleteRequest, dataServicesPtr[iClose], NULL);
+    dataServicesPtr[iClose] = nullptr;
+  }
+  return dataServicesPtr[iFrame];
+}
+
+
+// -------------------------------------------------------------------
+// ---- set the file ranges of frame iFrame if they have not been found
+// ---- yet.  the global range covers only the frames found so far, so
+// ---- it is widened here, along with the subregion and user ranges
+// ---- that still equal it.  returns true if the global range changed.
+bool PltApp::FindFrameRange(int iFrame) {
+  int iCDerNum(pltAppState->CurrentDerivedNumber());
+  if(pltAppState->IsSet(Amrvis::FILEGLOBALMINMAX, iFrame, iCDerNum)) {
+    return false;
+  }
+  const string asCDer(pltAppState->CurrentDerived());
+  const AmrData &amrData = FrameDataServices(currentFrame)->AmrDataRef();
+  int coarseLevel(0);
+  FindAndSetMinMax(Amrvis::FILEGLOBALMINMAX, iFrame, asCDer, iCDerNum,
+		   amrData.ProbDomain(), coarseLevel, amrData.FinestLevel(), false);
+  Real rFileMin, rFileMax;
+  pltAppState->GetMinMax(Amrvis::FILEGLOBALMINMAX, iFrame, iCDerNum,
+			 rFileMin, rFileMax);
+  if( ! pltAppState->IsSet(Amrvis::FILESUBREGIONMINMAX, iFrame, iCDerNum)) {
+    pltAppState->SetMinMax(Amrvis::FILESUBREGIONMINMAX, iFrame, iCDerNum,
+			   rFileMin, rFileMax);
+  }
+  if( ! pltAppState->IsSet(Amrvis::FILEUSERMINMAX, iFrame, iCDerNum)) {
+    pltAppState->SetMinMax(Amrvis::FILEUSERMINMAX, iFrame, iCDerNum,
+			   rFileMin, rFileMax);
+  }
+
+  Real rGlobalMin, rGlobalMax;
+  pltAppState->GetMinMax(Amrvis::GLOBALMINMAX, iFrame, iCDerNum, rGlobalMin, rGlobalMax);
+  if(rFileMin >= rGlobalMin && rFileMax <= rGlobalMax) {
+    return false;
+  }
+  Real rNewMin(min(rFileMin, rGlobalMin)), rNewMax(max(rFileMax, rGlobalMax));
   for(int i(0); i < animFrames; ++i) {
-    if(readyFrames[i] == true) {
-      XDestroyImage(frameBuffer[i]);
+    Real rTempMin, rTempMax;
+    pltAppState->GetMinMax(Amrvis::SUBREGIONMINMAX, i, iCDerNum, rTempMin, rTempMax);
+    if(rTempMin == rGlobalMin && rTempMax == rGlobalMax) {
+      pltAppState->SetMinMax(Amrvis::SUBREGIONMINMAX, i, iCDerNum, rNewMin, rNewMax);
+    }
+    pltAppState->GetMinMax(Amrvis::USERMINMAX, i, iCDerNum, rTempMin, rTempMax);
+    if(rTempMin == rGlobalMin && rTempMax == rGlobalMax) {
+      pltAppState->SetMinMax(Amrvis::USERMINMAX, i, iCDerNum, rNewMin, rNewMax);
     }
-    readyFrames[i] = false;
+    pltAppState->SetMinMax(Amrvis::GLOBALMINMAX, i, iCDerNum, rNewMin, rNewMax);
+  }
+  if(AVGlobals::Verbose()) {
+    cout << "_in PltApp::FindFrameRange:  frame " << iFrame << " widened the global range to "
+         << rNewMin << "  " << rNewMax << endl;
   }
+  return true;
+}
+
+
+// -------------------------------------------------------------------
+// ---- the frame on the screen, or nullptr if it is not cached
+const CachedFrame *PltApp::CurrentFrame() {
+  return FrameCache::TheFrameCache().Peek(this, currentFrame);
 }
 
 
@@ -4880,15 +5070,22 @@ void PltApp::DoUpdateFrame(Widget, XtPointer, XtPointer) {
   ShowFrame();
   XSync(display, false);
   animationIId = AddStaticTimeOut(frameSpeed, &PltApp::DoUpdateFrame);
+  StartPrefetch();
 }
 
 
 // -------------------------------------------------------------------
 void PltApp::ShowFrame() {
   interfaceReady = false;
-  const AmrData &amrData = dataServicesPtr[currentFrame]->AmrDataRef();
-  if( ! readyFrames[currentFrame] || datasetShowing || bSyncFrame ||
-      UsingFileRange(currentRangeType))
+  if(FindFrameRange(currentFrame)) {  // ---- the cached frames used the old range
+    DirtyFrames();
+  }
+  const AmrData &amrData = FrameDataServices(currentFrame)->AmrDataRef();
+  FrameCache &frameCache = FrameCache::TheFrameCache();
+  CachedFrame *cframe(frameCache.Find(this, currentFrame));
+  bool bNewFrame(false);
+  if(cframe == nullptr || datasetShowing || bSyncFrame ||
+     UsingFileRange(currentRangeType))
   {
 #if (BL_SPACEDIM != 3)
     AmrPicture *tempapSF = amrPicturePtrArray[Amrvis::ZPLANE];
@@ -4912,22 +5109,29 @@ void PltApp::ShowFrame() {
 					      pltPaletteptr);
     AddStaticEventHandler(wPlotPlane[Amrvis::ZPLANE], ExposureMask,
 			  &PltApp::PADoExposePicture, (XtPointer) Amrvis::ZPLANE);
-    frameBuffer[currentFrame] = amrPicturePtrArray[Amrvis::ZPLANE]->GetPictureXImage();
+    cframe = amrPicturePtrArray[Amrvis::ZPLANE]->MakeCachedFrame();
+    pictureFrame = currentFrame;
+    bNewFrame = true;
 #endif
-    readyFrames[currentFrame] = true;
     paletteDrawn = ! UsingFileRange(currentRangeType);
     bSyncFrame = false;
   }
   
-  XPutImage(display, XtWindow(wPlotPlane[Amrvis::ZPLANE]), xgc,
-	    frameBuffer[currentFrame], 0, 0, 0, 0,
-	    amrPicturePtrArray[Amrvis::ZPLANE]->ImageSizeH(),
-	    amrPicturePtrArray[Amrvis::ZPLANE]->ImageSizeV());
-  
+  if(cframe != nullptr) {
+    amrPicturePtrArray[Amrvis::ZPLANE]->PutCachedFrame(*cframe);
+  }
 
-  if(AVGlobals::CacheAnimFrames() == false) {
-    XDestroyImage(frameBuffer[currentFrame]);
-    readyFrames[currentFrame] = false;
+  if(bNewFrame) {
+    if(AVGlobals::CacheAnimFrames()) {
+      frameCache.Insert(this, currentFrame, cframe);
+    } else {
+      delete cframe;
+      frameCache.Erase(this, currentFrame);
+    }
+  }
+  if(AVGlobals::Verbose() && currentFrame == animFrames - 1) {
+    frameCache.PrintStats(cout);
+    gaPtr->PrintImageStats(cout);
   }
 
 
@@ -5085,6 +5289,17 @@ void PltApp::StaticTimeOut(XtPointer client_data, XtIntervalId * call_data) {
 }
 
 
+// -------------------------------------------------------------------
+Boolean PltApp::StaticPrefetch(XtPointer client_data) {
+  PltApp *obj = (PltApp *) client_data;
+  if(obj->PrefetchNextFrame()) {
+    obj->prefetchWPId = 0;
+    return True;
+  }
+  return False;
+}
+
+
 // -------------------------------------------------------------------
 int  PltApp::initialScale;
 int  PltApp::initialMaxMenuItems = 20;
@@ -93,7 +93,7 @@ void PltApp::DoTransInput(Widget /*w*/, XtPointer, XtPointer call_data) {
     
 #if defined(BL_VOLUMERENDER) || defined(BL_PARALLELVOLUMERENDER)
     if(XmToggleButtonGetState(wAutoDraw)) {
-      DoRender();
+      DoMotionRender(cbs->event);
     } else {
       viewTrans.MakeTransform();
       if(showing3dRender) {
@@ -133,7 +133,7 @@ void PltApp::DoTransInput(Widget /*w*/, XtPointer, XtPointer call_data) {
     
 #if defined(BL_VOLUMERENDER) || defined(BL_PARALLELVOLUMERENDER)
     if(XmToggleButtonGetState(wAutoDraw)) {
-      DoRender();
+      DoMotionRender(cbs->event);
     } else {
       viewTrans.MakeTransform();
       if(showing3dRender) {
@@ -165,7 +165,7 @@ void PltApp::DoTransInput(Widget /*w*/, XtPointer, XtPointer call_data) {
     
 #if defined(BL_VOLUMERENDER) || defined(BL_PARALLELVOLUMERENDER)
     if(XmToggleButtonGetState(wAutoDraw)) {
-      DoRender();
+      DoMotionRender(cbs->event);
     } else {
       viewTrans.MakeTransform();
       if(showing3dRender) {
@@ -785,6 +785,15 @@ void PltApp::DoAutoDraw(Widget, XtPointer, XtPointer) {
 
 // -------------------------------------------------------------------
 void PltApp::DoRenderModeMenu(Widget w, XtPointer item_no, XtPointer /*client_data*/) {
+#if defined(BL_VOLUMERENDER)
+  if(item_no == (XtPointer) 2) {  // ---- the ray caster, shaded with the mode
+    projPicturePtr->SetRayCast(XmToggleButtonGetState(w));
+    if(XmToggleButtonGetState(wAutoDraw) || showing3dRender) {
+      DoRender();
+    }
+    return;
+  }
+#endif
   if(wCurrentRenderMode == w) {
     XtVaSetValues(w, XmNset, true, NULL);
     return;
@@ -835,16 +844,89 @@ void PltApp::DoClassifyMenu(Widget w, XtPointer item_no, XtPointer /*client_data
 void PltApp::DoRender(Widget, XtPointer, XtPointer) {
   showing3dRender = true;
 
-  VolRender *volRender = projPicturePtr->GetVolRenderPtr();
-  if( ! volRender->SWFDataValid()) {
-    int iPaletteStart = pltPaletteptr->PaletteStart();
-    int iPaletteEnd   = pltPaletteptr->PaletteEnd();
-    int iBlackIndex   = pltPaletteptr->BlackIndex();
-    int iWhiteIndex   = pltPaletteptr->WhiteIndex();
-    int iColorSlots   = pltPaletteptr->ColorSlots();
-    Real minUsing, maxUsing;
-    pltAppState->GetMinMax(minUsing, maxUsing);
+  if(projPicturePtr->RayCast()) {
+    MakeRayCastData();
+  } else {
+    MakeRenderData(projPicturePtr->GetVolRenderPtr());
+  }
+
+  projPicturePtr->MakePicture();
+  projPicturePtr->DrawPicture();
+}
+
+
+// -------------------------------------------------------------------
+// ---- a quick picture from a coarser level while the view is moving
+void PltApp::DoPreviewRender() {
+  if(projPicturePtr->RayCast()) {
+    showing3dRender = true;
+    MakeRayCastData();
+    projPicturePtr->MakePicture(true);
+    projPicturePtr->DrawPicture();
+    return;
+  }
+  VolRender *previewRender = projPicturePtr->GetPreviewRenderPtr();
+  if(previewRender == nullptr) {
+    DoRender();
+    return;
+  }
+  showing3dRender = true;
+
+  MakeRenderData(previewRender);
 
+  projPicturePtr->MakePicture(true);
+  projPicturePtr->DrawPicture();
+}
+
+
+// -------------------------------------------------------------------
+// ---- render for a mouse event in the transform window.  dragging
+// ---- renders previews, and a motion event with another one queued
+// ---- right behind it is not rendered at all, so the picture keeps
+// ---- up with the mouse.  the full picture is rendered on release.
+void PltApp::DoMotionRender(XEvent *event) {
+  if(event->xany.type == ButtonRelease) {
+    DoRender();
+    return;
+  }
+  if(event->xany.type == MotionNotify) {
+    if(XEventsQueued(display, QueuedAfterReading) > 0) {
+      XEvent nextEvent;
+      XPeekEvent(display, &nextEvent);
+      if(nextEvent.xany.type == MotionNotify &&
+         nextEvent.xany.window == event->xany.window)
+      {
+        return;
+      }
+    }
+  }
+  DoPreviewRender();
+}
+
+
+// -------------------------------------------------------------------
+void PltApp::MakeRenderData(VolRender *volRender) {
+  if(volRender->VPDataValid()) {
+    return;
+  }
+  int iPaletteStart = pltPaletteptr->PaletteStart();
+  int iPaletteEnd   = pltPaletteptr->PaletteEnd();
+  int iBlackIndex   = pltPaletteptr->BlackIndex();
+  int iWhiteIndex   = pltPaletteptr->WhiteIndex();
+  int iColorSlots   = pltPaletteptr->ColorSlots();
+  Real minUsing, maxUsing;
+  pltAppState->GetMinMax(minUsing, maxUsing);
+
+  // ---- a stored classified volume skips both the swf and vp data
+  string cacheKey(volRender->ClassifiedCacheKey(dataServicesPtr[currentFrame],
+                                                minUsing, maxUsing,
+                                                pltAppState->CurrentDerived(),
+                                                iPaletteStart, iColorSlots,
+                                                pltAppState->GetShowingBoxes()));
+  if(volRender->LoadClassifiedVolume(cacheKey)) {
+    return;
+  }
+  if( ! volRender->SWFDataValid()) {
     volRender->MakeSWFData(dataServicesPtr[currentFrame],
 			   minUsing, maxUsing,
 			   pltAppState->CurrentDerived(), 
@@ -852,12 +934,27 @@ void PltApp::DoRender(Widget, XtPointer, XtPointer) {
 			   iBlackIndex, iWhiteIndex,
 			   iColorSlots, pltAppState->GetShowingBoxes());
   }
-  if( ! volRender->VPDataValid()) {
-    volRender->MakeVPData();
-  }
+  volRender->MakeVPData();
+  volRender->StoreClassifiedVolume(cacheKey);
+}
 
-  projPicturePtr->MakePicture();
-  projPicturePtr->DrawPicture();
+
+// -------------------------------------------------------------------
+void PltApp::MakeRayCastData() {
+  AmrRayCaster *rayCaster = projPicturePtr->GetRayCasterPtr();
+  int iPaletteStart = pltPaletteptr->PaletteStart();
+  int iColorSlots   = pltPaletteptr->ColorSlots();
+  Real minUsing, maxUsing;
+  pltAppState->GetMinMax(minUsing, maxUsing);
+
+  if( ! rayCaster->DataMatches(dataServicesPtr[currentFrame], minUsing, maxUsing,
+                               pltAppState->CurrentDerived(),
+                               iPaletteStart, iColorSlots))
+  {
+    rayCaster->MakeGridData(dataServicesPtr[currentFrame], minUsing, maxUsing,
+                            pltAppState->CurrentDerived(),
+                            iPaletteStart, iColorSlots);
+  }
 }
 #endif
 
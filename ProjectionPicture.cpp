@@ -6,12 +6,16 @@
 #include <X11/X.h>
 
 #include <ProjectionPicture.H>
+#include <ImageKernels.H>
+#include <GraphicsAttributes.H>
+#include <GridIndex.H>
 #include <PltApp.H>
 #include <PltAppState.H>
 #include <AMReX_DataServices.H>
 #include <Volume.H>
 #include <time.h>
 
+#include <algorithm>
 #include <cmath>
 #include <ctime>
 
@@ -44,7 +48,7 @@ ProjectionPicture::ProjectionPicture(PltApp *pltappptr, ViewTransform *vtptr,
 
   showSubCut = false;
   pixCreated = false;
-  imageData = NULL;
+  PPXImage = nullptr;
   volpackImageData = 0;
   maxDataLevel = pltAppPtr->GetPltAppState()->MaxAllowableLevel();
   theDomain = amrPicturePtr->GetSubDomain();
@@ -52,18 +56,31 @@ ProjectionPicture::ProjectionPicture(PltApp *pltappptr, ViewTransform *vtptr,
 #ifdef BL_VOLUMERENDER
   volRender = new VolRender(theDomain, minDrawnLevel, maxDrawnLevel, palettePtr,
 			    pltAppPtr->GetLightingFileName());
+  previewRender = nullptr;
+  previewLevel = -1;
+  previewStamp = -1;
+  previewImageData = nullptr;
+  rayCaster = new AmrRayCaster(theDomain, minDrawnLevel, maxDrawnLevel, maxDataLevel);
+  bRayCast = false;
 #endif
 
   SetDrawingAreaDimensions(daWidth, daHeight);
 
   const AmrData &amrData = pltAppPtr->GetDataServicesPtr()->AmrDataRef();
 
-  boxReal.resize(maxDataLevel + 1);
+  boxCorners.resize(maxDataLevel + 1);
   boxTrans.resize(maxDataLevel + 1);
+  boxVisible.resize(maxDataLevel + 1);
+  Vector< Vector<int> > domainGrids(maxDataLevel + 1);
   for(lev = minDrawnLevel; lev <= maxDataLevel; ++lev) {
-    int nBoxes(amrData.NIntersectingGrids(lev, theDomain[lev]));
-    boxReal[lev].resize(nBoxes);
+    GridIndex::Intersecting(amrData.boxArray(lev), theDomain[lev], domainGrids[lev]);
+    int nBoxes(domainGrids[lev].size());
+    for(int dir(0); dir < 3; ++dir) {
+      boxCorners[lev].lo[dir].resize(nBoxes);
+      boxCorners[lev].hi[dir].resize(nBoxes);
+    }
     boxTrans[lev].resize(nBoxes);
+    boxVisible[lev].resize(nBoxes, 1);
   }
   subCutColor = palettePtr->makePixel(palettePtr->SafePaletteIndex(maxDataLevel + 1,
                                                                   maxDataLevel));
@@ -78,14 +95,12 @@ ProjectionPicture::ProjectionPicture(PltApp *pltappptr, ViewTransform *vtptr,
       boxColors[lev] = palettePtr->makePixel(
                                  palettePtr->SafePaletteIndex(lev, maxDataLevel));
     }
-    for(int iBox(0); iBox < amrData.boxArray(lev).size(); ++iBox) {
-      Box temp(amrData.boxArray(lev)[iBox]);
-      if(temp.intersects(theDomain[lev])) {
-        temp &= theDomain[lev];
-        AddBox(temp.refine(amrex::CRRBetweenLevels(lev, maxDataLevel,
-               amrData.RefRatio())), iBoxIndex, lev);
-	++iBoxIndex;
-      }
+    for(int iGrid(0); iGrid < domainGrids[lev].size(); ++iGrid) {
+      Box temp(amrData.boxArray(lev)[domainGrids[lev][iGrid]]);
+      temp &= theDomain[lev];
+      AddBox(temp.refine(amrex::CRRBetweenLevels(lev, maxDataLevel,
+             amrData.RefRatio())), iBoxIndex, lev);
+      ++iBoxIndex;
     }
   }
   Box alignedBox(theDomain[minDrawnLevel]);
@@ -112,13 +127,16 @@ ProjectionPicture::ProjectionPicture(PltApp *pltappptr, ViewTransform *vtptr,
 
 // -------------------------------------------------------------------
 ProjectionPicture::~ProjectionPicture() {
-  delete [] imageData;
+  pltAppPtr->GetGAptr()->DestroyImage(PPXImage);
   delete [] volpackImageData;
   if(pixCreated) {
     XFreePixmap(XtDisplay(drawingArea), pixMap);
   }
 #ifdef BL_VOLUMERENDER
   delete volRender;
+  delete previewRender;
+  delete [] previewImageData;
+  delete rayCaster;
 #endif
 }
 
@@ -145,22 +163,71 @@ void ProjectionPicture::ResetPalette(Palette *newpally) {
 
 // -------------------------------------------------------------------
 void ProjectionPicture::AddBox(const Box &theBox, int index, int level) {
-  boxReal[level][index] = AVRealBox(theBox);
+  for(int dir(0); dir < 3; ++dir) {
+    boxCorners[level].lo[dir][index] = static_cast<Real>(theBox.smallEnd(dir));
+    boxCorners[level].hi[dir][index] = static_cast<Real>(theBox.bigEnd(dir) + 1);
+  }
 }
 
 
 // -------------------------------------------------------------------
-void ProjectionPicture::TransformBoxPoints(int iLevel, int iBoxIndex) {
-  Real px, py, pz;
+// ---- TransformPoint for every box on the level.  each screen
+// ---- coordinate is a sum of one term per direction, so the eight
+// ---- vertices need only the low and high terms of each direction.
+// ---- boxes off the drawing area or inside one pixel are marked not
+// ---- visible so they are not drawn.
+void ProjectionPicture::TransformBoxes(int iLevel) {
+  Real center[3], rot[2][3], tScale;
+  int offset[2];
+  viewTransformPtr->GetLinearTransform(center, rot, tScale, offset);
+
+  // ---- the (lo, hi) corner of each direction for the AVRealBox vertex order
+  static const int vertexSide[NVERTICIES][3] = { { 0, 0, 0 }, { 1, 0, 0 },
+                                                 { 1, 1, 0 }, { 0, 1, 0 },
+                                                 { 0, 0, 1 }, { 1, 0, 1 },
+                                                 { 1, 1, 1 }, { 0, 1, 1 } };
+  const BoxCorners &corners = boxCorners[iLevel];
+  Vector<TransBox> &tBoxes = boxTrans[iLevel];
+  Vector<char> &visible = boxVisible[iLevel];
+  int nBoxes(tBoxes.size());
+  int width(daWidth), height(daHeight);
+
+#ifdef _OPENMP
+#pragma omp parallel for if(nBoxes > 4096)
+#endif
+  for(int iBox = 0; iBox < nBoxes; ++iBox) {
+    int hTerm[3][2], vTerm[3][2];
+    for(int dir(0); dir < 3; ++dir) {
+      Real lo(corners.lo[dir][iBox] - center[dir]);
+      Real hi(corners.hi[dir][iBox] - center[dir]);
+      hTerm[dir][0] = (int) (lo * rot[0][dir] * tScale);
+      hTerm[dir][1] = (int) (hi * rot[0][dir] * tScale);
+      vTerm[dir][0] = (int) (lo * rot[1][dir] * tScale);
+      vTerm[dir][1] = (int) (hi * rot[1][dir] * tScale);
+    }
+    TransBox &tBox = tBoxes[iBox];
+    for(int i(0); i < NVERTICIES; ++i) {
+      int px(hTerm[0][vertexSide[i][0]] + hTerm[1][vertexSide[i][1]] +
+             hTerm[2][vertexSide[i][2]] + offset[0]);
+      int py(vTerm[0][vertexSide[i][0]] + vTerm[1][vertexSide[i][1]] +
+             vTerm[2][vertexSide[i][2]] + offset[1]);
+      // ---- (int) (p + 0.5) as in MakeBoundingBox, which rounds
+      // ---- negative values up
+      tBox.vertices[i].x = (px < 0 ? px + 1 : px);
+      tBox.vertices[i].y = height - (py < 0 ? py + 1 : py);
+    }
 
-  for(int i(0); i < NVERTICIES; ++i) {
-    viewTransformPtr->
-	   TransformPoint(boxReal[iLevel][iBoxIndex].vertices[i].component[0],
-			  boxReal[iLevel][iBoxIndex].vertices[i].component[1],
-			  boxReal[iLevel][iBoxIndex].vertices[i].component[2],
-			  px, py, pz);
-    boxTrans[iLevel][iBoxIndex].vertices[i] =
-	     TransPoint((int)(px + 0.5), daHeight - (int)(py + 0.5));
+    int xMin(tBox.vertices[0].x), xMax(tBox.vertices[0].x);
+    int yMin(tBox.vertices[0].y), yMax(tBox.vertices[0].y);
+    for(int i(1); i < NVERTICIES; ++i) {
+      xMin = std::min(xMin, tBox.vertices[i].x);
+      xMax = std::max(xMax, tBox.vertices[i].x);
+      yMin = std::min(yMin, tBox.vertices[i].y);
+      yMax = std::max(yMax, tBox.vertices[i].y);
+    }
+    bool bOffArea(xMax < 0 || yMax < 0 || xMin >= width || yMin >= height);
+    bool bInPixel(xMax == xMin && yMax == yMin);
+    visible[iBox] = ( ! bOffArea && ! bInPixel);
   }
 }
 
@@ -172,10 +239,7 @@ void ProjectionPicture::MakeBoxes() {
 
   if(pltAppPtr->GetPltAppState()->GetShowingBoxes()) {
     for(int iLevel(minDrawnLevel); iLevel <= maxDrawnLevel; ++iLevel) {
-      int nBoxes(boxTrans[iLevel].size());
-      for(int iBox(0); iBox < nBoxes; ++iBox) {
-        TransformBoxPoints(iLevel, iBox);
-      }
+      TransformBoxes(iLevel);
     }
   }
 
@@ -242,9 +306,9 @@ void ProjectionPicture::MakeSlices() {
 
 
 // -------------------------------------------------------------------
-void ProjectionPicture::MakePicture() {
+void ProjectionPicture::MakePicture(bool bPreview) {
 #ifdef BL_VOLUMERENDER
-  clock_t time0 = clock();
+  double time0(ParallelDescriptor::second());
 
   scale[Amrvis::XDIR] = viewTransformPtr->GetScale();
   scale[Amrvis::YDIR] = viewTransformPtr->GetScale();
@@ -258,30 +322,75 @@ void ProjectionPicture::MakePicture() {
   viewTransformPtr->MakeTransform();
 
   viewTransformPtr->GetRenderRotationMat(mvmat);
-  volRender->MakePicture(mvmat, tempLen, daWidth, daHeight);
 
-  // map imageData colors to colormap range
+  // ---- volpack scales the volume to the window, so the coarser
+  // ---- preview volume uses the same transform into a smaller image
+  VolRender *renderPtr = volRender;
+  unsigned char *renderImageData = volpackImageData;
+  int renderWidth(daWidth), renderHeight(daHeight), renderScale(1);
+  if(bPreview && (bRayCast || previewRender != nullptr)) {
+    renderPtr = previewRender;
+    renderImageData = previewImageData;
+    renderWidth  = (daWidth  + 1) / 2;
+    renderHeight = (daHeight + 1) / 2;
+    renderScale  = 2;
+  }
+
   Palette *palPtr = pltAppPtr->GetPalettePtr();
-  if(palPtr->ColorSlots() != palPtr->PaletteSize()) {
-    const unsigned char *remapTable = palPtr->RemapTable();
-    for(int idat(0); idat < daWidth * daHeight; ++idat) {
-      volpackImageData[idat] = remapTable[(unsigned char) volpackImageData[idat]];
-    }
+  if(bRayCast) {
+    // ---- the ray caster uses the view of the grid boxes, so the
+    // ---- picture lines up with them
+    AmrRayCaster::RayView rayView;
+    int offset[2];
+    viewTransformPtr->GetLinearTransform(rayView.center, rayView.rot,
+                                         rayView.scale, offset);
+    rayView.offset[0] = offset[0];
+    rayView.offset[1] = offset[1];
+    rayView.height = daHeight;
+
+    AmrRayCaster::RayShading rayShading;
+    rayShading.bLighting = volRender->GetLightingModel();
+    rayShading.ambient   = volRender->GetAmbient();
+    rayShading.diffuse   = volRender->GetDiffuse();
+    rayShading.specular  = volRender->GetSpecular();
+    rayShading.shiny     = volRender->GetShiny();
+    rayShading.minRayOpacity = volRender->GetMinRayOpacity();
+    rayShading.maxRayOpacity = volRender->GetMaxRayOpacity();
+    rayCaster->SetShading(rayShading);
+
+    Vector<float> opacity(palPtr->GetTransferArray());
+    opacity[palPtr->BodyIndex()] = (float) AVGlobals::GetBodyOpacity();
+    rayCaster->SetTransfer(opacity);
+
+    rayCaster->Render(renderImageData, renderWidth, renderHeight, renderScale,
+                      rayView);
+  } else {
+    renderPtr->MakePicture(mvmat, tempLen, renderWidth, renderHeight);
   }
 
-  for(int j(0); j < daHeight; ++j ) {
-    for(int i(0); i < daWidth; ++i ) {
-      unsigned char imm1 = volpackImageData[i+j*daWidth];
-      XPutPixel(PPXImage, i, j, palPtr->makePixel(imm1));
-      // imageData[i+j*daWidth] = imm1;
-    }
+  double time1(ParallelDescriptor::second());
+
+  // ---- map the image to the colormap range and to pixels in one pass
+  const unsigned char *remapTable = nullptr;
+  if(palPtr->ColorSlots() != palPtr->PaletteSize()) {
+    remapTable = palPtr->RemapTable();
   }
+  AVImage::WriteScaledImage(PPXImage, renderImageData, renderWidth, renderHeight,
+                            renderScale, *palPtr, false, remapTable);
+  double time2(ParallelDescriptor::second());
 
-  XPutImage(XtDisplay(drawingArea), pixMap, XtScreen(drawingArea)->
-            default_gc, PPXImage, 0, 0, 0, 0, daWidth, daHeight);
+  pltAppPtr->GetGAptr()->PutImage(pixMap, XtScreen(drawingArea)->default_gc,
+                                  PPXImage, 0, 0, 0, 0, daWidth, daHeight);
 
   if(AVGlobals::Verbose()) {
-    cout << "----- make picture time = " << ((clock()-time0)/1000000.0) << endl;
+    double time3(ParallelDescriptor::second());
+    cout << "----- make " << (renderScale > 1 ? "preview " : "")
+         << "picture time = " << (time3 - time0) << "  (render = "
+         << (time1 - time0) << ", pixels = " << (time2 - time1)
+         << ", put = " << (time3 - time2) << ")  "
+         << static_cast<long>(daWidth) * daHeight * PPXImage->bits_per_pixel / 8
+         << " bytes " << (pltAppPtr->GetGAptr()->SharedImages() ? "shared" : "copied")
+         << endl;
   }
 
 #endif
@@ -289,6 +398,53 @@ void ProjectionPicture::MakePicture() {
 }  // end MakePicture()
 
 
+#ifdef BL_VOLUMERENDER
+// -------------------------------------------------------------------
+// ---- the preview renders the finest level below the drawn level
+// ---- with no more than AVGlobals::PreviewCells() cells, or the
+// ---- coarsest drawn level if none is that small.  it is remade when
+// ---- the data, classification, or lighting of volRender change.
+VolRender *ProjectionPicture::GetPreviewRenderPtr() {
+  long previewCells(AVGlobals::PreviewCells());
+  if(previewCells <= 0 || minDrawnLevel >= maxDrawnLevel ||
+     theDomain[maxDrawnLevel].numPts() <= previewCells)
+  {
+    return nullptr;
+  }
+  int pLevel(minDrawnLevel);
+  for(int lev(maxDrawnLevel - 1); lev > minDrawnLevel; --lev) {
+    if(theDomain[lev].numPts() <= previewCells) {
+      pLevel = lev;
+      break;
+    }
+  }
+
+  if(previewRender != nullptr &&
+     (pLevel != previewLevel || previewStamp != volRender->StateStamp()))
+  {
+    delete previewRender;
+    previewRender = nullptr;
+  }
+  if(previewRender == nullptr) {
+    previewRender = new VolRender(theDomain, minDrawnLevel, pLevel, palettePtr,
+                                  pltAppPtr->GetLightingFileName());
+    previewRender->SetLightingModel(volRender->GetLightingModel());
+    previewRender->SetPreClassifyAlgorithm(volRender->GetPreClassifyAlgorithm());
+    previewRender->SetLighting(volRender->GetAmbient(), volRender->GetDiffuse(),
+                               volRender->GetSpecular(), volRender->GetShiny(),
+                               volRender->GetMinRayOpacity(),
+                               volRender->GetMaxRayOpacity());
+    previewRender->SetImage(previewImageData, (daWidth + 1) / 2,
+                            (daHeight + 1) / 2, VP_LUMINANCE);
+    previewRender->SetAspect(volRender->GetAspect());
+    previewLevel = pLevel;
+    previewStamp = volRender->StateStamp();
+  }
+  return previewRender;
+}
+#endif
+
+
 // -------------------------------------------------------------------
 void ProjectionPicture::DrawBoxes(int iFromLevel, int iToLevel) {
   DrawBoxesIntoDrawable(XtWindow(drawingArea), iFromLevel, iToLevel);
@@ -303,14 +459,25 @@ void ProjectionPicture::DrawBoxesIntoDrawable(const Drawable &drawable,
   maxDrawnLevel = pltAppPtr->GetPltAppState()->MaxDrawnLevel();
   
   if(pltAppPtr->GetPltAppState()->GetShowingBoxes()) {
+    // ---- one request per level, without the boxes that cannot be
+    // ---- seen and with the edges shared by neighboring boxes once
+    Vector<XSegment> segments;
     for(int iLevel(iFromLevel); iLevel <= iToLevel; ++iLevel) {
       XSetForeground(XtDisplay(drawingArea), XtScreen(drawingArea)->default_gc,
                      boxColors[iLevel]);
       int nBoxes(boxTrans[iLevel].size());
+      segments.clear();
+      segments.reserve(12 * nBoxes);
       for(int iBox(0); iBox < nBoxes; ++iBox) {
-        boxTrans[iLevel][iBox].Draw(XtDisplay(drawingArea), drawable,
-                                    XtScreen(drawingArea)->default_gc);
-        
+        if(boxVisible[iLevel][iBox]) {
+          boxTrans[iLevel][iBox].AddEdges(segments);
+        }
+      }
+      AVImage::MergeSegments(segments);
+      if(segments.size() > 0) {
+        XDrawSegments(XtDisplay(drawingArea), drawable,
+                      XtScreen(drawingArea)->default_gc,
+                      segments.dataPtr(), segments.size());
       }
     }
   }
@@ -435,29 +602,16 @@ void ProjectionPicture::SetDrawingAreaDimensions(int w, int h) {
   
   daWidth = w;
   daHeight = h;
-  int widthpad = (1+(w-1)/(XBitmapPad(XtDisplay(drawingArea))/8))*XBitmapPad(XtDisplay(drawingArea))/8;
 
-  if(imageData != NULL) {
-    delete [] imageData;
-    delete [] volpackImageData;
-  }
+  delete [] volpackImageData;
   volpackImageData = new unsigned char[daWidth*daHeight];
-  imageData = static_cast<unsigned char *> (malloc(widthpad * daHeight *
-                                        XBitmapPad(XtDisplay(drawingArea)) / 8));
-  if(imageData == NULL || volpackImageData == NULL ) {
-    cout << " SetDrawingAreaDimensions::imageData : new failed" << endl;
-    amrex::Abort("Exiting.");
-  }
   
   viewTransformPtr->SetScreenPosition(daWidth / 2, daHeight / 2);
   
-  PPXImage = XCreateImage(XtDisplay(drawingArea),
-			  XDefaultVisual(XtDisplay(drawingArea),
-					 DefaultScreen(XtDisplay(drawingArea))),
-			  DefaultDepthOfScreen(XtScreen(drawingArea)), ZPixmap, 0,
-			  (char *) imageData, widthpad, daHeight,
-			  XBitmapPad(XtDisplay(drawingArea)),
-			  widthpad * XBitmapPad(XtDisplay(drawingArea)) / 8);
+  // ---- a shared memory image when the server has MIT-SHM
+  GraphicsAttributes *gaPtr = pltAppPtr->GetGAptr();
+  gaPtr->DestroyImage(PPXImage);
+  PPXImage = gaPtr->CreateImage(daWidth, daHeight);
   
   if(pixCreated) {
     XFreePixmap(XtDisplay(drawingArea), pixMap);
@@ -471,17 +625,29 @@ void ProjectionPicture::SetDrawingAreaDimensions(int w, int h) {
   // --- set the image buffer
   volRender->SetImage( (unsigned char *) volpackImageData, daWidth, daHeight,
                        VP_LUMINANCE);
+  delete [] previewImageData;
+  previewImageData = new unsigned char[((daWidth + 1) / 2) * ((daHeight + 1) / 2)];
+  if(previewRender != nullptr) {
+    previewRender->SetImage(previewImageData, (daWidth + 1) / 2,
+                            (daHeight + 1) / 2, VP_LUMINANCE);
+  }
 #endif
   longestWindowLength  = (Real) max(daWidth, daHeight);
   shortestWindowLength = (Real) min(daWidth, daHeight);
   if(longestWindowLength == 0) {  // this happens when x deletes this window
 #ifdef BL_VOLUMERENDER
     volRender->SetAspect(1.0);
+    if(previewRender != nullptr) {
+      previewRender->SetAspect(1.0);
+    }
 #endif
     viewTransformPtr->SetAspect(1.0);
   } else {
 #ifdef BL_VOLUMERENDER
     volRender->SetAspect(shortestWindowLength/longestWindowLength);
+    if(previewRender != nullptr) {
+      previewRender->SetAspect(shortestWindowLength/longestWindowLength);
+    }
 #endif
     viewTransformPtr->SetAspect(shortestWindowLength/longestWindowLength);
   }
@@ -535,20 +701,27 @@ TransBox::TransBox() {
 
 //--------------------------------------------------------------------
 void TransBox::Draw(Display *display, Window window, GC gc) {
-  for(int j(0); j < 2; ++j) {
-    for(int i(0); i < 3; ++i) {
-      XDrawLine(display, window, gc,
-                vertices[j*4+i].x, vertices[j*4+i].y,
-                vertices[j*4+i+1].x, vertices[j*4+i+1].y);
-    }
-    XDrawLine(display, window, gc, vertices[j*4].x, vertices[j*4].y, 
-              vertices[j*4+3].x, vertices[j*4+3].y);
-  }
-  for(int k(0); k < 4; ++k) {
-    XDrawLine(display, window, gc, vertices[k].x, vertices[k].y,
-              vertices[k+4].x, vertices[k+4].y);
+  Vector<XSegment> segments;
+  AddEdges(segments);
+  XDrawSegments(display, window, gc, segments.dataPtr(), segments.size());
+}
+
+
+//--------------------------------------------------------------------
+void TransBox::AddEdges(Vector<XSegment> &segments) const {
+  static const int edgeVertices[12][2] = { { 0, 1 }, { 1, 2 }, { 2, 3 }, { 0, 3 },
+                                           { 4, 5 }, { 5, 6 }, { 6, 7 }, { 4, 7 },
+                                           { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+  for(int e(0); e < 12; ++e) {
+    const TransPoint &p1 = vertices[edgeVertices[e][0]];
+    const TransPoint &p2 = vertices[edgeVertices[e][1]];
+    XSegment seg;
+    seg.x1 = p1.x;
+    seg.y1 = p1.y;
+    seg.x2 = p2.x;
+    seg.y2 = p2.y;
+    segments.push_back(seg);
   }
-            
 }
 
 
@@ -0,0 +1,363 @@
+// ---------------------------------------------------------------
+// RangeIndex.cpp
+// ---------------------------------------------------------------
+#include <RangeIndex.H>
+#include <GlobalUtilities.H>
+#include <GridIndex.H>
+
+#include <AMReX_AmrData.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_FArrayBox.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::cout;
+using std::endl;
+using namespace amrex;
+
+namespace {
+  const string rangeIndexTag("amrvisranges");
+  const int rangeIndexVersion(1);
+  // ---- the sidecars are small, so a few readers are enough to hide latency
+  const int maxIndexReaders(8);
+  // ---- the edge length of the blocks a cut grid is split into
+  const int summaryBlockSize(32);
+
+  std::map<string, RangeIndex> &TheIndices() {
+    static std::map<string, RangeIndex> theIndices;
+    return theIndices;
+  }
+
+  // ---- keyed by plot file name and derived
+  std::map<std::pair<string, string>, GridRangeSummary> &TheSummaries() {
+    static std::map<std::pair<string, string>, GridRangeSummary> theSummaries;
+    return theSummaries;
+  }
+}
+
+
+// -------------------------------------------------------------------
+RangeIndex &RangeIndex::ForFile(const string &plotfilename) {
+  RangeIndex &rangeIndex = TheIndices()[plotfilename];
+  if( ! rangeIndex.bRead) {
+    rangeIndex.plotFileName = plotfilename;
+    rangeIndex.Read();
+  }
+  return rangeIndex;
+}
+
+
+// -------------------------------------------------------------------
+// ---- the map is filled here first so the readers only touch their
+// ---- own entries.
+void RangeIndex::ReadIndices(const Vector<string> &plotfilenames) {
+  Vector<RangeIndex *> toRead;
+  for(int i(0); i < plotfilenames.size(); ++i) {
+    RangeIndex &rangeIndex = TheIndices()[plotfilenames[i]];
+    if( ! rangeIndex.bRead) {
+      rangeIndex.plotFileName = plotfilenames[i];
+      rangeIndex.bRead = true;
+      toRead.push_back(&rangeIndex);
+    }
+  }
+  int nToRead(toRead.size());
+#ifdef _OPENMP
+  int nReaders(std::min(omp_get_max_threads(), maxIndexReaders));
+#pragma omp parallel for schedule(dynamic) num_threads(nReaders)
+#endif
+  for(int i = 0; i < nToRead; ++i) {
+    toRead[i]->Read();
+  }
+}
+
+
+// -------------------------------------------------------------------
+string RangeIndex::IndexFileName(const string &plotfilename) {
+  string baseName(plotfilename);
+  while(baseName.length() > 1 && baseName[baseName.length() - 1] == '/') {
+    baseName.erase(baseName.length() - 1);
+  }
+  return baseName + "." + rangeIndexTag;
+}
+
+
+// -------------------------------------------------------------------
+bool RangeIndex::Find(const string &derived, int level, const Box &onBox,
+                      Real &rmin, Real &rmax, bool &bValid) const
+{
+  std::map<string, RangeEntry>::const_iterator it(ranges.find(EntryKey(derived,
+                                                                        level, onBox)));
+  if(it == ranges.end()) {
+    return false;
+  }
+  rmin   = it->second.rMin;
+  rmax   = it->second.rMax;
+  bValid = it->second.bValid;
+  return true;
+}
+
+
+// -------------------------------------------------------------------
+void RangeIndex::Insert(const string &derived, int level, const Box &onBox,
+                        Real rmin, Real rmax, bool bValid, bool bWholeDomain)
+{
+  RangeEntry &entry = ranges[EntryKey(derived, level, onBox)];
+  entry.rMin   = rmin;
+  entry.rMax   = rmax;
+  entry.bValid = bValid;
+  entry.bWholeDomain = bWholeDomain;
+  if(bWholeDomain) {
+    bDirty = true;
+  }
+}
+
+
+// -------------------------------------------------------------------
+// ---- a sidecar that cannot be written (a read only directory, for
+// ---- example) is not an error, the ranges are just found again.
+// ---- the index is written to a temporary file and renamed over the
+// ---- old one, so a reader never sees a partly written index.
+void RangeIndex::Write() {
+  if( ! bDirty || ! AVGlobals::RangeIndexFiles() ||
+      ! ParallelDescriptor::IOProcessor())
+  {
+    return;
+  }
+  bDirty = false;
+  headerTime = HeaderTime(plotFileName);
+  string indexFileName(IndexFileName(plotFileName));
+  std::ostringstream tempName;  // ---- another session may write the same index
+  tempName << indexFileName << ".tmp" << getpid();
+  string tempFileName(tempName.str());
+  std::ofstream indexFile(tempFileName.c_str());
+  if( ! indexFile.good()) {
+    if(AVGlobals::Verbose()) {
+      cout << "_in RangeIndex::Write:  cannot write " << tempFileName << endl;
+    }
+    return;
+  }
+  indexFile.precision(std::numeric_limits<Real>::max_digits10);
+  indexFile << rangeIndexTag << ' ' << rangeIndexVersion << ' ' << headerTime << '\n';
+  // ---- the key is derived, level, then the box
+  for(std::map<string, RangeEntry>::const_iterator it = ranges.begin();
+      it != ranges.end(); ++it)
+  {
+    if(it->second.bWholeDomain) {
+      indexFile << it->second.bValid << ' ' << it->second.rMin << ' '
+                << it->second.rMax << ' ' << it->first << '\n';
+    }
+  }
+  indexFile.close();
+  if(indexFile.fail() || std::rename(tempFileName.c_str(), indexFileName.c_str()) != 0) {
+    if(AVGlobals::Verbose()) {
+      cout << "_in RangeIndex::Write:  cannot write " << indexFileName << endl;
+    }
+    std::remove(tempFileName.c_str());
+  }
+}
+
+
+// -------------------------------------------------------------------
+string RangeIndex::EntryKey(const string &derived, int level, const Box &onBox) {
+  std::ostringstream key;
+  key << derived << ' ' << level << ' ' << onBox;
+  return key.str();
+}
+
+
+// -------------------------------------------------------------------
+// ---- the modification time of the plot file header, or zero
+long RangeIndex::HeaderTime(const string &plotfilename) {
+  struct stat statBuf;
+  if(stat((plotfilename + "/Header").c_str(), &statBuf) == 0 ||
+     stat(plotfilename.c_str(), &statBuf) == 0)
+  {
+    return static_cast<long>(statBuf.st_mtime);
+  }
+  return 0;
+}
+
+
+// -------------------------------------------------------------------
+void RangeIndex::Read() {
+  bRead = true;
+  if( ! AVGlobals::RangeIndexFiles()) {
+    return;
+  }
+  headerTime = HeaderTime(plotFileName);
+  std::ifstream indexFile(IndexFileName(plotFileName).c_str());
+  if( ! indexFile.good() || headerTime == 0) {
+    return;
+  }
+  string tag;
+  int version(-1);
+  long indexTime(-1);
+  indexFile >> tag >> version >> indexTime;
+  if(tag != rangeIndexTag || version != rangeIndexVersion || indexTime != headerTime) {
+    return;  // ---- stale or foreign, it is rewritten when ranges are found
+  }
+  string line;
+  std::getline(indexFile, line);
+  while(std::getline(indexFile, line)) {
+    std::istringstream lineStream(line);
+    RangeEntry entry;
+    lineStream >> entry.bValid >> entry.rMin >> entry.rMax;
+    entry.bWholeDomain = true;
+    string key;
+    std::getline(lineStream >> std::ws, key);
+    if(lineStream.fail() || key.empty()) {
+      ranges.clear();
+      return;
+    }
+    ranges[key] = entry;
+  }
+}
+
+
+// -------------------------------------------------------------------
+GridRangeSummary &GridRangeSummary::ForData(DataServices *dsp, const string &derived) {
+  std::pair<string, string> key(dsp->GetFileName(), derived);
+  std::map<std::pair<string, string>, GridRangeSummary>::iterator it(TheSummaries().find(key));
+  if(it == TheSummaries().end()) {
+    it = TheSummaries().insert(std::make_pair(key, GridRangeSummary())).first;
+    it->second.Init(dsp, derived);
+  }
+  return it->second;
+}
+
+
+// -------------------------------------------------------------------
+// ---- cartesian grid ranges skip covered cells inside AmrData and
+// ---- regions holding every grid are answered from the fab headers,
+// ---- so both go straight to the MinMaxRequest.
+void GridRangeSummary::MinMax(DataServices *dsp, const Box &onBox, int level,
+                              Real &rmin, Real &rmax, bool &bValid)
+{
+  const AmrData &amrData = dsp->AmrDataRef();
+  const BoxArray &levelBA = amrData.boxArray(level);
+  if(amrData.CartGrid() || onBox.contains(levelBA.minimalBox())) {
+    DataServices::Dispatch(DataServices::MinMaxRequest, dsp,
+                           (void *) &onBox, (void *) &derivedName,
+                           level, &rmin, &rmax, &bValid);
+    return;
+  }
+
+  rmin =  std::numeric_limits<Real>::max();
+  rmax = -std::numeric_limits<Real>::max();
+  Vector<int> regionGrids;
+  GridIndex::Intersecting(levelBA, onBox, regionGrids);
+  bValid = ( ! regionGrids.empty());
+  for(int ig(0); ig < regionGrids.size(); ++ig) {
+    int iGrid(regionGrids[ig]);
+    const Box &gridBox = levelBA[iGrid];
+    if(onBox.contains(gridBox)) {
+      GridMinMax(dsp, level, iGrid);
+      rmin = std::min(rmin, gridRanges[level][iGrid].rMin);
+      rmax = std::max(rmax, gridRanges[level][iGrid].rMax);
+      continue;
+    }
+    if(gridBlocks[level][iGrid].empty()) {
+      SummarizeGrid(dsp, level, iGrid);
+    }
+    const Vector<BlockRange> &blocks = gridBlocks[level][iGrid];
+    for(int iBlock(0); iBlock < blocks.size(); ++iBlock) {
+      if( ! onBox.intersects(blocks[iBlock].box)) {
+        continue;
+      }
+      if(onBox.contains(blocks[iBlock].box)) {
+        rmin = std::min(rmin, blocks[iBlock].rMin);
+        rmax = std::max(rmax, blocks[iBlock].rMax);
+      } else {
+        ScanBox(dsp, blocks[iBlock].box & onBox, level, rmin, rmax);
+      }
+    }
+  }
+}
+
+
+// -------------------------------------------------------------------
+void GridRangeSummary::Init(DataServices *dsp, const string &derived) {
+  const AmrData &amrData = dsp->AmrDataRef();
+  int nLevels(amrData.FinestLevel() + 1);
+  derivedName = derived;
+  gridRanges.resize(nLevels);
+  bGridRangeSet.resize(nLevels);
+  gridBlocks.resize(nLevels);
+  for(int lev(0); lev < nLevels; ++lev) {
+    int nGrids(amrData.boxArray(lev).size());
+    gridRanges[lev].resize(nGrids);
+    bGridRangeSet[lev].resize(nGrids, false);
+    gridBlocks[lev].resize(nGrids);
+  }
+}
+
+
+// -------------------------------------------------------------------
+// ---- the whole grid range, from the fab header when AmrData has it
+void GridRangeSummary::GridMinMax(DataServices *dsp, int level, int iGrid) {
+  if(bGridRangeSet[level][iGrid]) {
+    return;
+  }
+  BlockRange &gridRange = gridRanges[level][iGrid];
+  gridRange.box = dsp->AmrDataRef().boxArray(level)[iGrid];
+  bool bValid(false);
+  DataServices::Dispatch(DataServices::MinMaxRequest, dsp,
+                         (void *) &(gridRange.box), (void *) &derivedName,
+                         level, &(gridRange.rMin), &(gridRange.rMax), &bValid);
+  bGridRangeSet[level][iGrid] = true;
+}
+
+
+// -------------------------------------------------------------------
+// ---- read the grid once and keep the range of each block
+void GridRangeSummary::SummarizeGrid(DataServices *dsp, int level, int iGrid) {
+  const Box &gridBox = dsp->AmrDataRef().boxArray(level)[iGrid];
+  FArrayBox gridFab(gridBox, 1);
+  DataServices::Dispatch(DataServices::FillVarOneFab, dsp,
+                         (void *) &gridFab, (void *) &(gridFab.box()),
+                         level, (void *) &derivedName);
+
+  BoxArray blockBA(gridBox);
+  blockBA.maxSize(summaryBlockSize);
+  Vector<BlockRange> &blocks = gridBlocks[level][iGrid];
+  blocks.resize(blockBA.size());
+  BlockRange &gridRange = gridRanges[level][iGrid];
+  gridRange.box  = gridBox;
+  gridRange.rMin =  std::numeric_limits<Real>::max();
+  gridRange.rMax = -std::numeric_limits<Real>::max();
+  for(int iBlock(0); iBlock < blockBA.size(); ++iBlock) {
+    blocks[iBlock].box  = blockBA[iBlock];
+    blocks[iBlock].rMin = gridFab.min(blockBA[iBlock], 0);
+    blocks[iBlock].rMax = gridFab.max(blockBA[iBlock], 0);
+    gridRange.rMin = std::min(gridRange.rMin, blocks[iBlock].rMin);
+    gridRange.rMax = std::max(gridRange.rMax, blocks[iBlock].rMax);
+  }
+  bGridRangeSet[level][iGrid] = true;
+}
+
+
+// -------------------------------------------------------------------
+void GridRangeSummary::ScanBox(DataServices *dsp, const Box &scanBox, int level,
+                               Real &rmin, Real &rmax)
+{
+  FArrayBox scanFab(scanBox, 1);
+  DataServices::Dispatch(DataServices::FillVarOneFab, dsp,
+                         (void *) &scanFab, (void *) &(scanFab.box()),
+                         level, (void *) &derivedName);
+  rmin = std::min(rmin, scanFab.min(0));
+  rmax = std::max(rmax, scanFab.max(0));
+}
+// ---------------------------------------------------------------
+// ---------------------------------------------------------------
@@ -5,6 +5,7 @@
 #include <Palette.H>
 #include <GraphicsAttributes.H>
 #include <ProfApp.H>
+#include <ImageKernels.H>
 
 using std::cout;
 using std::cerr;
@@ -77,12 +78,9 @@ void RegionPicture::RegionPictureInit(const amrex::Box &regionBox)
     cerr << "*** imageSizeV = " << imageSizeV << endl;
     amrex::Abort("Error in RegionPicture:  Image size too large.  Exiting.");
   }
-  int widthpad(gaPtr->PBitmapPaddedWidth(imageSizeH));
-  imageSize = imageSizeV * widthpad * gaPtr->PBytesPerPixel();
-
   imageData = new unsigned char[dataSize];
-  scaledImageData = new unsigned char[imageSize];
-  scaledImageDataDim = new unsigned char[imageSize];
+  xImage    = nullptr;
+  xImageDim = nullptr;
 
   atiDataSizeH = dataSizeH;
   atiDataSizeV = regionBaseHeight;
@@ -90,12 +88,10 @@ void RegionPicture::RegionPictureInit(const amrex::Box &regionBox)
 
   atiImageSizeH = currentScale * atiDataSizeH;
   atiImageSizeV = currentScale * atiDataSizeV;
-  int atiWidthpad = gaPtr->PBitmapPaddedWidth(atiImageSizeH);
-  atiImageSize = atiImageSizeV * atiWidthpad * gaPtr->PBytesPerPixel();
 
   atiImageData = new unsigned char[atiDataSize];
-  scaledATIImageData = new unsigned char[atiImageSize];
-  scaledATIImageDataDim = new unsigned char[atiImageSize];
+  atiXImage    = nullptr;
+  atiXImageDim = nullptr;
 
   subRegion = regionBox;
   cout << "subRegion = " << subRegion << endl;
@@ -110,11 +106,11 @@ void RegionPicture::RegionPictureInit(const amrex::Box &regionBox)
 // ---------------------------------------------------------------------
 RegionPicture::~RegionPicture() {
   delete [] imageData;
-  delete [] scaledImageData;
-  delete [] scaledImageDataDim;
   delete [] atiImageData;
-  delete [] scaledATIImageData;
-  delete [] scaledATIImageDataDim;
+  gaPtr->DestroyImage(xImage);
+  gaPtr->DestroyImage(xImageDim);
+  gaPtr->DestroyImage(atiXImage);
+  gaPtr->DestroyImage(atiXImageDim);
   delete sliceFab;
 
   if(pixMapCreated) {
@@ -133,10 +129,10 @@ void RegionPicture::APDraw(int /*fromLevel*/, int /*toLevel*/) {
   }  
   int invert(imageSizeV - currentScale - (regionBaseHeight * currentScale));
  
-  XPutImage(display, pixMap, xgc, xImage, 0, 0, 0, 0,
-	    imageSizeH, imageSizeV);
-  XPutImage(display, pixMap, xgc, atiXImage, 0, 0, 0, invert,
-	    atiImageSizeH, atiImageSizeV);
+  gaPtr->PutImage(pixMap, xgc, xImage, 0, 0, 0, 0,
+	          imageSizeH, imageSizeV);
+  gaPtr->PutImage(pixMap, xgc, atiXImage, 0, 0, 0, invert,
+	          atiImageSizeH, atiImageSizeV);
 
   XImage *xi, *atixi;
   for(auto it = timeSpanOff.begin(); it != timeSpanOff.end(); ++it) {
@@ -148,14 +144,14 @@ void RegionPicture::APDraw(int /*fromLevel*/, int /*toLevel*/) {
       int bLY(b.length(Amrvis::YDIR) * currentScale);
       xi    = xImageDim;
       atixi = atiXImageDim;
-      XPutImage(display, pixMap, xgc, xi,
-                bSX, invert - bBY,
-                bSX, invert - bBY,
-                bLX, bLY);
-      XPutImage(display, pixMap, xgc, atixi,
-                bSX, 0,
-                bSX, invert,
-                bLX, atiImageSizeV);
+      gaPtr->PutImage(pixMap, xgc, xi,
+                      bSX, invert - bBY,
+                      bSX, invert - bBY,
+                      bLX, bLY);
+      gaPtr->PutImage(pixMap, xgc, atixi,
+                      bSX, 0,
+                      bSX, invert,
+                      bLX, atiImageSizeV);
   }
 
   DoExposePicture();
@@ -237,10 +233,10 @@ void RegionPicture::APMakeImages(Palette *palptr) {
 
   CreateImage(*(sliceFab), imageData, dataSizeH, dataSizeV, minUsing, maxUsing, palPtr);
   CreateScaledImage(&(xImage), currentScale,
-                imageData, scaledImageData, dataSizeH, dataSizeV,
+                imageData, dataSizeH, dataSizeV,
                 imageSizeH, imageSizeV);
   CreateScaledImage(&(xImageDim), currentScale,
-                imageData, scaledImageDataDim, dataSizeH, dataSizeV,
+                imageData, dataSizeH, dataSizeV,
                 imageSizeH, imageSizeV, true);  // ---- make dim
   for(int j(0); j < atiDataSizeV; ++j) {
     for(int i(0); i < atiDataSizeH; ++i) {
@@ -248,10 +244,10 @@ void RegionPicture::APMakeImages(Palette *palptr) {
     }
   }
   CreateScaledImage(&(atiXImage), currentScale,
-                atiImageData, scaledATIImageData, atiDataSizeH, atiDataSizeV,
+                atiImageData, atiDataSizeH, atiDataSizeV,
                 atiImageSizeH, atiImageSizeV);
   CreateScaledImage(&(atiXImageDim), currentScale,
-                atiImageData, scaledATIImageDataDim, atiDataSizeH, atiDataSizeV,
+                atiImageData, atiDataSizeH, atiDataSizeV,
                 atiImageSizeH, atiImageSizeV, true);  // ---- make dim
 
   palptr->DrawPalette(minUsing, maxUsing, "%8.2f");
@@ -266,81 +262,31 @@ void RegionPicture::CreateImage(const FArrayBox &fab, unsigned char *imagedata,
 			        int datasizeh, int datasizev,
 			        Real globalMin, Real globalMax, Palette *palptr)
 {
-  int jdsh, jtmp1;
-  int dIndex, iIndex;
-  Real gDiff(globalMax - globalMin);
-  Real oneOverGDiff;
-  if((globalMax - globalMin) < FLT_MIN) {
-    oneOverGDiff = 0.0;
-  } else {
-    oneOverGDiff = 1.0 / gDiff;
-  }
   const Real *dataPoint = fab.dataPtr();
 
   // flips the image in Vert dir: j => datasizev-j-1
-  Real dPoint;
+  // ---- set both background and ati (dPoint < 0) to -2 (black in palette)
   int paletteStart(palptr->PaletteStart());
   int paletteEnd(palptr->PaletteEnd());
   int colorSlots(palptr->ColorSlots());
-  for(int j(0); j < datasizev; ++j) {
-    jdsh = j * datasizeh;
-    jtmp1 = (datasizev-j-1) * datasizeh;
-    for(int i(0); i < datasizeh; ++i) {
-      dIndex = i + jtmp1;
-      dPoint = dataPoint[dIndex];
-      if(dPoint < 0.0) {
-        dPoint = -2.0;  // ---- set both background and ati to -2 (black in palette)
-      }
-      iIndex = i + jdsh;
-      if(dPoint > globalMax) {  // clip
-        imagedata[iIndex] = paletteEnd;
-      } else if(dPoint < globalMin) {  // clip
-        imagedata[iIndex] = paletteStart;
-      } else {
-        imagedata[iIndex] = (unsigned char)
-              ((((dPoint - globalMin) * oneOverGDiff) * colorSlots) );
-              //  ^^^^^^^^^^^^^^^^^^ Real data
-        imagedata[iIndex] += paletteStart;
-      } 
-    }
-  }
+  AVImage::QuantizeToIndex(dataPoint, imagedata, datasizeh, datasizev,
+                           globalMin, globalMax, colorSlots,
+                           paletteStart, paletteEnd, true);
 }
 
 
 // ---------------------------------------------------------------------
 void RegionPicture::CreateScaledImage(XImage **ximage, int scale,
 				      unsigned char *imagedata,
-				      unsigned char *scaledimagedata,
-				      int datasizeh, int /*datasizev*/,
+				      int datasizeh, int datasizev,
 				      int imagesizeh, int imagesizev,
 				      bool dim)
 { 
-  int widthpad(gaPtr->PBitmapPaddedWidth(imagesizeh));
-  *ximage = XCreateImage(display, gaPtr->PVisual(), gaPtr->PDepth(),
-                         ZPixmap, 0, (char *) scaledimagedata,
-		         widthpad, imagesizev, XBitmapPad(display),
-			 widthpad * gaPtr->PBytesPerPixel());
-
-  unsigned char imm1;
-  if(dim) {
-    for(int j(0); j < imagesizev; ++j) {
-      int jtmp(datasizeh * (j / scale));
-      for(int i(0); i < widthpad; ++i) {
-        int itmp(i / scale);
-        imm1 = imagedata[ itmp + jtmp ];
-        XPutPixel(*ximage, i, j, palPtr->makePixelDim(imm1));
-      }
-    }
-  } else {
-    for(int j(0); j < imagesizev; ++j) {
-      int jtmp(datasizeh * (j / scale));
-      for(int i(0); i < widthpad; ++i) {
-        int itmp(i / scale);
-        imm1 = imagedata[ itmp + jtmp ];
-        XPutPixel(*ximage, i, j, palPtr->makePixel(imm1));
-      }
-    }
-  }
+  gaPtr->DestroyImage(*ximage);
+  *ximage = gaPtr->CreateImage(imagesizeh, imagesizev);
+
+  AVImage::WriteScaledImage(*ximage, imagedata, datasizeh, datasizev,
+                            scale, *palPtr, dim);
 }
 
 
@@ -349,8 +295,6 @@ void RegionPicture::APChangeScale(int newScale, int /*previousScale*/) {
   currentScale = newScale;
   imageSizeH = currentScale * dataSizeH;
   imageSizeV = currentScale * dataSizeV;
-  int widthpad = gaPtr->PBitmapPaddedWidth(imageSizeH);
-  imageSize  = widthpad * imageSizeV * gaPtr->PBytesPerPixel();
   XClearWindow(display, pictureWindow);
 
   if(pixMapCreated) {
@@ -361,30 +305,20 @@ void RegionPicture::APChangeScale(int newScale, int /*previousScale*/) {
 			 gaPtr->PDepth());
   pixMapCreated = true;
 
-  delete [] scaledImageData;
-  delete [] scaledImageDataDim;
-  scaledImageData = new unsigned char[imageSize];
-  scaledImageDataDim = new unsigned char[imageSize];
   CreateScaledImage(&xImage, currentScale,
-                    imageData, scaledImageData, dataSizeH, dataSizeV,
+                    imageData, dataSizeH, dataSizeV,
                     imageSizeH, imageSizeV);
   CreateScaledImage(&xImageDim, currentScale,
-                    imageData, scaledImageDataDim, dataSizeH, dataSizeV,
+                    imageData, dataSizeH, dataSizeV,
                     imageSizeH, imageSizeV, true);  // ---- make dim
 
   atiImageSizeH = currentScale * atiDataSizeH;
   atiImageSizeV = currentScale * atiDataSizeV;
-  int atiWidthpad = gaPtr->PBitmapPaddedWidth(atiImageSizeH);
-  atiImageSize  = atiWidthpad * atiImageSizeV * gaPtr->PBytesPerPixel();
-  delete [] scaledATIImageData;
-  delete [] scaledATIImageDataDim;
-  scaledATIImageData = new unsigned char[atiImageSize];
-  scaledATIImageDataDim = new unsigned char[atiImageSize];
   CreateScaledImage(&(atiXImage), currentScale,
-                atiImageData, scaledATIImageData, atiDataSizeH, atiDataSizeV,
+                atiImageData, atiDataSizeH, atiDataSizeV,
                 atiImageSizeH, atiImageSizeV);
   CreateScaledImage(&(atiXImageDim), currentScale,
-                atiImageData, scaledATIImageDataDim, atiDataSizeH, atiDataSizeV,
+                atiImageData, atiDataSizeH, atiDataSizeV,
                 atiImageSizeH, atiImageSizeV, true);  // ---- make dim
 
   APDraw(0, 0);
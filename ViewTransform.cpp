@@ -85,6 +85,24 @@ void ViewTransform::TransformPoint(Real x, Real y, Real z,
 }
 
 
+// -------------------------------------------------------------------
+void ViewTransform::GetLinearTransform(Real center[3], Real rot[2][3],
+                                       Real &tScale, int offset[2]) const
+{
+  center[0] = objCenterX;
+  center[1] = objCenterY;
+  center[2] = objCenterZ;
+  for(int ii(0); ii < 2; ++ii) {
+    for(int jj(0); jj < 3; ++jj) {
+      rot[ii][jj] = mRotation[ii][jj];
+    }
+  }
+  tScale = scale;
+  offset[0] = (int) (mRotation[0][3]) + screenPositionX;
+  offset[1] = (int) (mRotation[1][3]) + screenPositionY;
+}
+
+
 // -------------------------------------------------------------------
 void ViewTransform::Print() const {
     cout << "ViewTransform::Print() does nothing now." << endl;
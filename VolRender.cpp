@@ -4,11 +4,15 @@
 #include <VolRender.H>
 #include <AMReX_DataServices.H>
 #include <GlobalUtilities.H>
+#include <GridIndex.H>
+#include <RangeIndex.H>
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_AmrvisConstants.H>
 
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
+#include <sstream>
 using std::cerr;
 using std::cout;
 using std::endl;
@@ -16,6 +20,10 @@ using std::endl;
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <cerrno>
 #include <time.h>
 
 using namespace amrex;
@@ -24,6 +32,246 @@ using namespace amrex;
 extern Real RadToDeg(Real angle);
 extern Real DegToRad(Real angle);
 
+
+namespace {
+
+  // -------------------------------------------------------------------
+  // ---- grids burned in on different threads can share edge voxels
+  inline void SetBoxVoxel(unsigned char *swfdata, long sindex,
+                          unsigned char color)
+  {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+    swfdata[sindex] = color;
+  }
+
+
+  // -------------------------------------------------------------------
+  // ---- burn the edges of edgebox, on a level crr times coarser than
+  // ---- swfdatabox, into swfdata.  only the cells on two or more faces
+  // ---- of edgebox are visited.  with breversez the planes are
+  // ---- mirrored in levdomain, as the data planes are.
+  void BurnInBoxEdges(unsigned char *swfdata, const Box &swfdatabox,
+                      const Box &edgebox, const Box &levdomain, int crr,
+                      bool breversez, unsigned char color)
+  {
+    int srows(swfdatabox.length(Amrvis::XDIR));
+    long scolssrowstmp(static_cast<long>(swfdatabox.length(Amrvis::YDIR)) * srows);
+    int sstartr(swfdatabox.smallEnd(Amrvis::XDIR));
+    int sstartp(swfdatabox.smallEnd(Amrvis::ZDIR));
+    int sendc(swfdatabox.bigEnd(Amrvis::YDIR));
+    int zsum(levdomain.smallEnd(Amrvis::ZDIR) + levdomain.bigEnd(Amrvis::ZDIR));
+    int lor(edgebox.smallEnd(Amrvis::XDIR)), hir(edgebox.bigEnd(Amrvis::XDIR));
+    int loc(edgebox.smallEnd(Amrvis::YDIR)), hic(edgebox.bigEnd(Amrvis::YDIR));
+    int lop(edgebox.smallEnd(Amrvis::ZDIR)), hip(edgebox.bigEnd(Amrvis::ZDIR));
+
+    for(int p(lop); p <= hip; ++p) {
+      int edgep((p == lop || p == hip) ? 1 : 0);
+      int pswf(breversez ? zsum - p : p);
+      for(int c(loc); c <= hic; ++c) {
+        int edgec((c == loc || c == hic) ? 1 : 0);
+        if(edgep + edgec == 0) {
+          continue;  // ---- no edges cross the inside of a face
+        }
+        // ---- on one face only the row ends are on an edge
+        int rstep(edgep + edgec > 1 ? 1 : std::max(1, hir - lor));
+        for(int r(lor); r <= hir; r += rstep) {
+          long sindexbase(((static_cast<long>(pswf) * crr - sstartp) * scolssrowstmp) +
+                          ((sendc - c * crr) * srows) + (r * crr - sstartr));
+          if(crr == 1) {
+            SetBoxVoxel(swfdata, sindexbase, color);
+            continue;
+          }
+          for(int sp(0); sp < crr; ++sp) {
+            int onEdgep(((p == lop && sp == 0) || (p == hip && sp == crr - 1)) ? 1 : 0);
+            for(int sc(0); sc < crr; ++sc) {
+              int onEdgec(((c == loc && sc == 0) || (c == hic && sc == crr - 1)) ? 1 : 0);
+              for(int sr(0); sr < crr; ++sr) {
+                int onEdger(((r == lor && sr == 0) || (r == hir && sr == crr - 1)) ? 1 : 0);
+                if((onEdger + onEdgec + onEdgep) > 1) {
+                  SetBoxVoxel(swfdata, sindexbase + (sp * scolssrowstmp) -
+                                       (sc * srows) + sr, color);
+                }
+              }
+            }
+          }  // end for(sp...)
+        }
+      }
+    }  // end for(p...)
+  }
+
+  // -------------------------------------------------------------------
+  // ---- 64 bit fnv-1a, for naming the classified volume cache files
+  unsigned long long HashBytes(const void *bytes, long nbytes,
+                               unsigned long long hash = 14695981039346656037ULL)
+  {
+    const unsigned char *b = static_cast<const unsigned char *>(bytes);
+    for(long i(0); i < nbytes; ++i) {
+      hash = (hash ^ b[i]) * 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  // -------------------------------------------------------------------
+  // ---- the offset in swfdata of the row of brick cells (bbox, c, p).
+  // ---- swfdata planes are reversed and its columns run from the top.
+  inline long SWFRowOffset(const Box &swfdatabox, const Box &bbox, int c, int p) {
+    int srows(swfdatabox.length(Amrvis::XDIR));
+    long scolssrowstmp(static_cast<long>(swfdatabox.length(Amrvis::YDIR)) * srows);
+    return ((swfdatabox.bigEnd(Amrvis::ZDIR) - p) * scolssrowstmp) +
+           ((swfdatabox.bigEnd(Amrvis::YDIR) - c) * srows) +
+           (bbox.smallEnd(Amrvis::XDIR) - swfdatabox.smallEnd(Amrvis::XDIR));
+  }
+
+
+  // -------------------------------------------------------------------
+  // ---- clip and scale a brick of data into palette indices in swfdata
+  void QuantizeBrick(const FArrayBox &brickfab, unsigned char *swfdata,
+                     const Box &swfdatabox, Real gmin, Real gmax,
+                     int paletteStart, int colorSlots)
+  {
+    Real globalDiff(gmax - gmin);
+    Real oneOverGDiff;
+    if(globalDiff < FLT_MIN) {
+      oneOverGDiff = 0.0;  // so we dont divide by zero
+    } else {
+      oneOverGDiff = 1.0 / globalDiff;
+    }
+    int cSlotsAvail(colorSlots - 1);
+    const Box &bbox = brickfab.box();
+    const Real *dataPoint = brickfab.dataPtr();
+    int grows(bbox.length(Amrvis::XDIR));
+    int gcols(bbox.length(Amrvis::YDIR));
+    int gplanes(bbox.length(Amrvis::ZDIR));
+    long gcolsgrowstmp(static_cast<long>(gcols) * grows);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int gp = 0; gp < gplanes; ++gp) {
+      for(int gc(0); gc < gcols; ++gc) {
+        const Real *dataRow = dataPoint + gp * gcolsgrowstmp + gc * grows;
+        unsigned char *swfRow = swfdata +
+                                SWFRowOffset(swfdatabox, bbox, gc + bbox.smallEnd(Amrvis::YDIR),
+                                             gp + bbox.smallEnd(Amrvis::ZDIR));
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+        for(int gr = 0; gr < grows; ++gr) {
+          Real dat(std::min(std::max(dataRow[gr], gmin), gmax));  // clip data
+          swfRow[gr] = (unsigned char) ((char) (((dat - gmin) * oneOverGDiff) *
+                                                cSlotsAvail)
+                                        + (char) paletteStart);
+        }
+      }
+    }  // end for(gp...)
+  }
+
+
+  // -------------------------------------------------------------------
+  // ---- color the cartgrid body cells of a brick of vfrac data
+  void BurnInBody(const FArrayBox &vfracfab, unsigned char *swfdata,
+                  const Box &swfdatabox, Real vfeps, unsigned char bodycolor)
+  {
+    const Box &bbox = vfracfab.box();
+    const Real *dataPoint = vfracfab.dataPtr();
+    int grows(bbox.length(Amrvis::XDIR));
+    int gcols(bbox.length(Amrvis::YDIR));
+    int gplanes(bbox.length(Amrvis::ZDIR));
+    long gcolsgrowstmp(static_cast<long>(gcols) * grows);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int gp = 0; gp < gplanes; ++gp) {
+      for(int gc(0); gc < gcols; ++gc) {
+        const Real *dataRow = dataPoint + gp * gcolsgrowstmp + gc * grows;
+        unsigned char *swfRow = swfdata +
+                                SWFRowOffset(swfdatabox, bbox, gc + bbox.smallEnd(Amrvis::YDIR),
+                                             gp + bbox.smallEnd(Amrvis::ZDIR));
+        for(int gr(0); gr < grows; ++gr) {
+          if(dataRow[gr] < vfeps) {  // body
+            swfRow[gr] = bodycolor;
+          }
+        }
+      }
+    }  // end for(gp...)
+  }
+
+  // ---- the most cells filled from the plotfile at a time
+  const long swfBrickCells(16L * 1024L * 1024L);
+
+  const string classifiedCacheTag("AmrvisClassifiedVolume");
+  const int classifiedCacheVersion(1);
+  const string classifiedCacheSuffix(".amrvisvp");
+
+  // -------------------------------------------------------------------
+  // ---- true if st is owned by this user and no one else can write it.
+  // ---- only such cache directories and files are used, so another
+  // ---- user cannot plant volumes in the cache.
+  bool PrivateStat(const struct stat &st) {
+    return st.st_uid == geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+  }
+
+  // -------------------------------------------------------------------
+  bool PrivateCacheDir(const string &dirname, bool bcreate) {
+    if(bcreate && mkdir(dirname.c_str(), 0700) != 0 && errno != EEXIST) {
+      return false;
+    }
+    struct stat st;
+    return (lstat(dirname.c_str(), &st) == 0 && S_ISDIR(st.st_mode) &&
+            PrivateStat(st));
+  }
+
+  // -------------------------------------------------------------------
+  // ---- remove the least recently used cache files until the
+  // ---- rest total at most maxbytes.  a hit touches its file.
+  void EvictCacheFiles(const string &dirname, long maxbytes) {
+    DIR *dir = opendir(dirname.c_str());
+    if(dir == nullptr) {
+      return;
+    }
+    struct CacheFile {
+      time_t mtime;
+      long bytes;
+      string name;
+      bool operator<(const CacheFile &rhs) const { return mtime < rhs.mtime; }
+    };
+    Vector<CacheFile> cacheFiles;
+    long totalBytes(0);
+    struct dirent *entry;
+    while((entry = readdir(dir)) != nullptr) {
+      string name(entry->d_name);
+      if(name.size() <= classifiedCacheSuffix.size() ||
+         name.compare(name.size() - classifiedCacheSuffix.size(),
+                      string::npos, classifiedCacheSuffix) != 0)
+      {
+        continue;
+      }
+      name = dirname + '/' + name;
+      struct stat st;
+      if(lstat(name.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+        CacheFile cf = { st.st_mtime, static_cast<long>(st.st_size), name };
+        cacheFiles.push_back(cf);
+        totalBytes += cf.bytes;
+      }
+    }
+    closedir(dir);
+    std::sort(cacheFiles.begin(), cacheFiles.end());
+    for(int i(0); i < cacheFiles.size() && totalBytes > maxbytes; ++i) {
+      if(unlink(cacheFiles[i].name.c_str()) == 0) {
+        totalBytes -= cacheFiles[i].bytes;
+        if(AVGlobals::Verbose()) {
+          cout << "_in EvictCacheFiles:  removed " << cacheFiles[i].name << endl;
+        }
+      }
+    }
+  }
+
+}  // end anonymous namespace
+
+
 #define CheckVP(vpret, n)  \
 	  if(vpret != VP_OK) { \
             cerr << "VolPack error " << n << ":  " \
@@ -38,12 +286,16 @@ VolRender::VolRender(const Vector<Box> &drawdomain, int mindrawnlevel,
                      const string &asLightFileName)
 {
   bDrawAllBoxes = false;
+  stateStamp = 0;
   minDrawnLevel = mindrawnlevel;
   maxDataLevel = maxdrawnlevel;
   drawnDomain = drawdomain;
   vpDataValid     = false;
   swfDataValid    = false;
   swfDataAllocated = false;
+  swfDataMapped    = false;
+  swfData = nullptr;
+  swfDataSize = 0;
   palettePtr = paletteptr;
   preClassify = true;
 
@@ -153,7 +405,11 @@ VolRender::~VolRender() {
     delete [] volData;
     //cout << "_after delete [] volData:  volData = " << volData << endl;
     if(swfDataAllocated) {
-      delete [] swfData;
+      if(swfDataMapped) {
+        munmap(swfData, swfDataSize);
+      } else {
+        delete [] swfData;
+      }
     }
   }
 }
@@ -168,6 +424,33 @@ bool VolRender::AllocateSWFData() {
   cout << "swfData box size = "
        << drawnDomain[maxDataLevel] << "  " << swfDataSize << endl;
 
+  // ---- a volume over the memory limit is kept in an unlinked scratch
+  // ---- file, so the planes not in use can be paged out
+  if(swfDataSize > AVGlobals::VolumeMemMB() * 1024L * 1024L) {
+    const char *tmpDir = getenv("TMPDIR");
+    string scratchDir(tmpDir != nullptr ? tmpDir : "/tmp");
+    string scratchName(scratchDir + "/amrvisvolXXXXXX");
+    int fd(mkstemp(&scratchName[0]));
+    if(fd >= 0) {
+      unlink(scratchName.c_str());
+      if(ftruncate(fd, swfDataSize) == 0) {
+        void *mapped = mmap(nullptr, swfDataSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+        if(mapped != MAP_FAILED) {
+          swfData = static_cast<unsigned char *>(mapped);
+          swfDataMapped = true;
+        }
+      }
+      close(fd);
+    }
+    if(swfDataMapped) {
+      cout << "swfData is in a scratch file in " << scratchDir << endl;
+      swfDataAllocated = true;
+      return swfDataAllocated;
+    }
+    cerr << "Warning:  could not map a scratch file for swfData, using memory." << endl;
+  }
+
   swfData = new unsigned char[swfDataSize];
   if(swfData == NULL) {
     cerr << "Error in AmrPicture::ChangeDerived:  could not allocate "
@@ -180,6 +463,25 @@ bool VolRender::AllocateSWFData() {
 }
 
 
+// -------------------------------------------------------------------
+// ---- let the pages of swfData planes zfirst to zfirst + nplanes - 1
+// ---- go back to the scratch file.  they are read again when used.
+void VolRender::ReleaseSWFPlanes(int zfirst, int nplanes) {
+  if( ! swfDataMapped || nplanes < 1) {
+    return;
+  }
+  long planeSize(static_cast<long>(rows) * cols);
+  long pageSize(sysconf(_SC_PAGESIZE));
+  long first(zfirst * planeSize);
+  long last(first + nplanes * planeSize);
+  first = ((first + pageSize - 1) / pageSize) * pageSize;  // ---- whole pages only
+  last  = (last / pageSize) * pageSize;
+  if(last > first) {
+    madvise(swfData + first, last - first, MADV_DONTNEED);
+  }
+}
+
+
 // -------------------------------------------------------------------
 void VolRender::MakeSWFData(amrex::DataServices *dataServicesPtr,
 			    Real rDataMin, Real rDataMax,
@@ -207,360 +509,92 @@ void VolRender::MakeSWFData(amrex::DataServices *dataServicesPtr,
   }
   
   swfDataValid = true;
-  clock_t time0 = clock();
+  double fillTime(0.0), quantizeTime(0.0), boxesTime(0.0), bodyTime(0.0);
   
   int maxDrawnLevel(maxDataLevel);
-  Box grefbox;
 
   Box swfDataBox(drawnDomain[maxDrawnLevel]);
+  int sendp(swfDataBox.bigEnd(Amrvis::ZDIR));
+  long swfPlaneSize(static_cast<long>(swfDataBox.length(Amrvis::XDIR)) *
+                    swfDataBox.length(Amrvis::YDIR));
+  int brickPlanes(static_cast<int>(std::max(1L, swfBrickCells / swfPlaneSize)));
 
-  FArrayBox swfFabData;
   if(ParallelDescriptor::IOProcessor()) {
-    swfFabData.resize(swfDataBox, 1);
+    cout << "Filling swfFabData..." << endl;
   }
-  
-  amrex::DataServices::Dispatch(DataServices::FillVarOneFab, dataServicesPtr,
-                         (void *) &swfFabData,
-			 (void *) &swfDataBox,
-			 maxDrawnLevel,
-			 (void *) &derivedName);
+
+  // ---- the data is filled and quantized a brick of planes at a time,
+  // ---- so the whole volume is never held as Reals
+  FArrayBox swfFabData;
+  for(int bzlo(swfDataBox.smallEnd(Amrvis::ZDIR)); bzlo <= sendp; bzlo += brickPlanes) {
+    Box brickBox(swfDataBox);
+    brickBox.setSmall(Amrvis::ZDIR, bzlo);
+    brickBox.setBig(Amrvis::ZDIR, std::min(bzlo + brickPlanes - 1, sendp));
+    double tFill(ParallelDescriptor::second());
+    if(ParallelDescriptor::IOProcessor()) {
+      swfFabData.resize(brickBox, 1);
+    }
+    amrex::DataServices::Dispatch(DataServices::FillVarOneFab, dataServicesPtr,
+                           (void *) &swfFabData,
+			   (void *) &brickBox,
+			   maxDrawnLevel,
+			   (void *) &derivedName);
+    double tQuantize(ParallelDescriptor::second());
+    fillTime += tQuantize - tFill;
+    if(ParallelDescriptor::IOProcessor()) {
+      QuantizeBrick(swfFabData, swfData, swfDataBox, rDataMin, rDataMax,
+                    iPaletteStart, iColorSlots);
+      ReleaseSWFPlanes(sendp - brickBox.bigEnd(Amrvis::ZDIR),
+                       brickBox.length(Amrvis::ZDIR));
+    }
+    quantizeTime += ParallelDescriptor::second() - tQuantize;
+  }  // end for(bzlo...)
   
   if(ParallelDescriptor::IOProcessor()) {
-    Real gmin(rDataMin);
-    Real gmax(rDataMax);
-    Real globalDiff(gmax - gmin);
-    Real oneOverGDiff;
-    if(globalDiff < FLT_MIN) {
-      oneOverGDiff = 0.0;  // so we dont divide by zero
-    } else {
-      oneOverGDiff = 1.0 / globalDiff;
-    }
-    int cSlotsAvail(iColorSlots - 1);
-    
-    cout << "Filling swfFabData..." << endl;
-    
-    // copy data into swfData and change to chars
-    Real dat;
-    char chardat;
-    Real *dataPoint = swfFabData.dataPtr();
-    
-    int sindexbase;
-    int srows   = swfDataBox.length(Amrvis::XDIR);
-    int scols   = swfDataBox.length(Amrvis::YDIR);
-    //int splanes = swfDataBox.length(Amrvis::ZDIR);
-    int scolssrowstmp = scols*srows;
-    int sstartr = swfDataBox.smallEnd(Amrvis::XDIR);
-    //int sstartc = swfDataBox.smallEnd(Amrvis::YDIR);
-    int sstartp = swfDataBox.smallEnd(Amrvis::ZDIR);
-    //int sendr   = swfDataBox.bigEnd(Amrvis::XDIR);
-    int sendc   = swfDataBox.bigEnd(Amrvis::YDIR);
-    //int sendp   = swfDataBox.bigEnd(Amrvis::ZDIR);
-    
-    Box gbox(swfDataBox);
-    Box goverlap(gbox & drawnDomain[maxDrawnLevel]);
-    
-    int gstartr = gbox.smallEnd(Amrvis::XDIR);
-    int gstartc = gbox.smallEnd(Amrvis::YDIR);
-    int gstartp = gbox.smallEnd(Amrvis::ZDIR);
-    
-    int gostartr = goverlap.smallEnd(Amrvis::XDIR) - gstartr;
-    int gostartc = goverlap.smallEnd(Amrvis::YDIR) - gstartc;
-    int gostartp = goverlap.smallEnd(Amrvis::ZDIR) - gstartp;
-    int goendr   = goverlap.bigEnd(Amrvis::XDIR)   - gstartr;
-    int goendc   = goverlap.bigEnd(Amrvis::YDIR)   - gstartc;
-    int goendp   = goverlap.bigEnd(Amrvis::ZDIR)   - gstartp;
-    
-    int grows   = gbox.length(Amrvis::XDIR);
-    int gcols   = gbox.length(Amrvis::YDIR);
-    //int gplanes = gbox.length(Amrvis::ZDIR);
-    
-    int gcolsgrowstmp(gcols * grows);
-    int gpgcgrtmp, gcgrowstmp;
-    for(int gp(gostartp); gp <= goendp; ++gp) {
-      gpgcgrtmp = gp * gcolsgrowstmp;
-      for(int gc(gostartc); gc <= goendc; ++gc) {
-        gcgrowstmp = gpgcgrtmp + gc * grows;
-        for(int gr(gostartr); gr <= goendr; ++gr) {
-          //dat = dataPoint[(gp * gcols * grows) + (gc * grows) + gr];  // works
-          dat = dataPoint[gcgrowstmp + gr];
-          dat = max(dat,gmin); // clip data if out of range
-          dat = min(dat,gmax);
-          chardat = (char) (((dat - gmin) * oneOverGDiff) * cSlotsAvail);
-          chardat += (char) iPaletteStart;
-	  int gprev = gostartp + goendp - gp;
-          sindexbase =
-            //(((gp + gstartp) - sstartp) * scolssrowstmp) +
-            (((gprev + gstartp) - sstartp) * scolssrowstmp) +
-            ((sendc - ((gc + gstartc))) * srows) +  // check this
-            ((gr + gstartr) - sstartr);
-          
-          swfData[sindexbase] = chardat;
-        }
-      }
-    }  // end for(gp...)
-
                                                 // ---------------- VolumeBoxes
     bool bDrawVolumeBoxes(AVGlobals::GetBoxColor() > -1);  // need to limit
                                                            // to palmaxindex
     if(bDrawVolumeBoxes) {
-      int edger, edgec, edgep;
-      int volumeBoxColor(AVGlobals::GetBoxColor());
-      int gr, gc, gp, sr, sc, sp, sindex;
+      boxesTime = ParallelDescriptor::second();
+      unsigned char volumeBoxColor(AVGlobals::GetBoxColor());
       AmrData &amrData = dataServicesPtr->AmrDataRef();
 
      if(bDrawAllBoxes) {
+      Vector<int> gridLevels, gridNumbers;
       for(int lev(minDrawnLevel); lev <= maxDrawnLevel; ++lev) {
+	// ---- grids outside the drawn domain add no edges
+	Vector<int> drawnGrids;
+	GridIndex::Intersecting(amrData.boxArray(lev), drawnDomain[lev], drawnGrids);
+	for(int iGrid(0); iGrid < drawnGrids.size(); ++iGrid) {
+	  gridLevels.push_back(lev);
+	  gridNumbers.push_back(drawnGrids[iGrid]);
+	}
+      }
+      // ---- the grids of all levels are burned in together
+      int nDrawnGrids(gridLevels.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for(int iDrawn = 0; iDrawn < nDrawnGrids; ++iDrawn) {
+        int lev(gridLevels[iDrawn]);
         int crr(amrex::CRRBetweenLevels(lev, maxDrawnLevel,
 	        amrData.RefRatio()));
-	const BoxArray &gridBoxes = amrData.boxArray(lev);
-	for(int iGrid(0); iGrid < gridBoxes.size(); ++iGrid) {
-          gbox = gridBoxes[iGrid];
-	  // grow high end by one to eliminate overlap
-	  //gbox.growHi(Amrvis::XDIR, 1);
-	  //gbox.growHi(Amrvis::YDIR, 1);
-	  //gbox.growHi(Amrvis::ZDIR, 1);
-	  //
-          Box goverlapdd(gbox & drawnDomain[lev]);
-          grefbox = goverlapdd;
-          grefbox.refine(crr);
-
-          int sGstartr(gbox.smallEnd(Amrvis::XDIR));
-          int sGstartc(gbox.smallEnd(Amrvis::YDIR));
-          int sGstartp(gbox.smallEnd(Amrvis::ZDIR));
-
-          int sGostartr(goverlapdd.smallEnd(Amrvis::XDIR) - sGstartr);
-          int sGostartc(goverlapdd.smallEnd(Amrvis::YDIR) - sGstartc);
-          int sGostartp(goverlapdd.smallEnd(Amrvis::ZDIR) - sGstartp);
-          int sGoendr(goverlapdd.bigEnd(Amrvis::XDIR)   - sGstartr);
-          int sGoendc(goverlapdd.bigEnd(Amrvis::YDIR)   - sGstartc);
-          int sGoendp(goverlapdd.bigEnd(Amrvis::ZDIR)   - sGstartp);
-
-          grows = gbox.length(Amrvis::XDIR);
-          gcols = gbox.length(Amrvis::YDIR);
-
-        if(crr != 1) {
-          int sGcolsgrowstmp(gcols * grows);
-	  int ddsez(drawnDomain[lev].smallEnd(Amrvis::ZDIR));
-	  int ddbez(drawnDomain[lev].bigEnd(Amrvis::ZDIR));
-          for(gp = sGostartp; gp <= sGoendp; ++gp) {
-            int gprev = ddsez + ddbez - (gp + sGstartp);
-	    if(gp == sGostartp || gp == sGoendp) {
-              edgep = 1;
-	    } else {
-              edgep = 0;
-	    }
-            gpgcgrtmp = gp * sGcolsgrowstmp;
-            for(gc = sGostartc; gc <= sGoendc; ++gc) {
-	      if(gc == sGostartc || gc == sGoendc) {
-                edgec = 1;
-	      } else {
-                edgec = 0;
-	      }
-              for(gr = sGostartr; gr <= sGoendr; ++gr) {
-		if(gr == sGostartr || gr == sGoendr) {
-                  edger = 1;
-		} else {
-                  edger = 0;
-		}
-                //sindexbase = (((gp + sGstartp) * crr - sstartp) * scolssrowstmp) +
-                sindexbase = (((gprev) * crr - sstartp) * scolssrowstmp) +
-                             ((sendc - ((gc + sGstartc) * crr)) * srows) +
-                             ((gr + sGstartr) * crr - sstartr);
-
-              if((edger + edgec + edgep) > 1) {
-                // (possibly) draw boxes into dataset
-                int onEdger, onEdgec, onEdgep;
-
-                for(sp = 0; sp < crr; ++sp) {
-		  if((gp==sGostartp && sp==0) || (gp==sGoendp && sp == (crr-1))) {
-                    onEdgep = 1;
-		  } else {
-                    onEdgep = 0;
-		  }
-                  for(sc = 0; sc < crr; ++sc) {
-		    if((gc==sGostartc && sc==0) || (gc==sGoendc && sc == (crr-1))) {
-                      onEdgec = 1;
-		    } else {
-                      onEdgec = 0;
-		    }
-                    for(sr = 0; sr < crr; ++sr) {
-		      if((gr==sGostartr && sr==0) || (gr==sGoendr && sr == (crr-1))) {
-                        onEdger = 1;
-		      } else {
-                        onEdger = 0;
-		      }
-                      if((onEdger + onEdgec + onEdgep) > 1) {
-                        sindex = sindexbase + ((sp * scolssrowstmp) -
-					       (sc * srows) + sr);
-                        swfData[sindex] = volumeBoxColor;
-                      }
-
-                    }
-                  }
-                }  // end for(sp...)
-              }
-              }
-            }
-          }  // end for(gp...)
-
-        } else {  // crr == 1
-	  int ddsez(drawnDomain[lev].smallEnd(Amrvis::ZDIR));
-	  int ddbez(drawnDomain[lev].bigEnd(Amrvis::ZDIR));
-          for(gp = sGostartp; gp <= sGoendp; ++gp) {
-            int gprev = ddsez + ddbez - (gp + sGstartp);
-	    if(gp == sGostartp || gp == sGoendp) {
-              edgep = 1;
-	    } else {
-              edgep = 0;
-	    }
-            for(gc = sGostartc; gc <= sGoendc; ++gc) {
-	      if(gc == sGostartc || gc == sGoendc) {
-                edgec = 1;
-	      } else {
-                edgec = 0;
-	      }
-              for(gr = sGostartr; gr <= sGoendr; ++gr) {
-		if(gr == sGostartr || gr == sGoendr) {
-                  edger = 1;
-		} else {
-                  edger = 0;
-		}
-                if((edger + edgec + edgep) > 1) {
-                  sindexbase =
-                      //(((gp + sGstartp) - sstartp) * scolssrowstmp) +
-                      ((gprev - sstartp) * scolssrowstmp) +
-                      ((sendc - ((gc + sGstartc))) * srows) +
-                      ((gr + sGstartr) - sstartr);
-                  swfData[sindexbase] = volumeBoxColor;
-                }
-              }
-            }
-          }  // end for(gp...)
-        }  // end if(crr...)
-
-        }  // end for(iGrid...)
-      }  // end for(lev...)
+        Box goverlapdd(amrData.boxArray(lev)[gridNumbers[iDrawn]] &
+                       drawnDomain[lev]);
+        BurnInBoxEdges(swfData, swfDataBox, goverlapdd, drawnDomain[lev], crr,
+                       true, volumeBoxColor);
+      }  // end for(iDrawn...)
 
      } else {  // only draw the boundingbox
 
         int lev(minDrawnLevel);
         int crr(amrex::CRRBetweenLevels(lev, maxDrawnLevel,
 	        amrData.RefRatio()));
-          gbox = drawnDomain[lev];
-          Box sGoverlap(gbox & drawnDomain[lev]);
-          grefbox = sGoverlap;
-          grefbox.refine(crr);
-
-          int sGstartr(gbox.smallEnd(Amrvis::XDIR));
-          int sGstartc(gbox.smallEnd(Amrvis::YDIR));
-          int sGstartp(gbox.smallEnd(Amrvis::ZDIR));
-
-          int sGostartr(sGoverlap.smallEnd(Amrvis::XDIR) - sGstartr);
-          int sGostartc(sGoverlap.smallEnd(Amrvis::YDIR) - sGstartc);
-          int sGostartp(sGoverlap.smallEnd(Amrvis::ZDIR) - sGstartp);
-          int sGoendr(sGoverlap.bigEnd(Amrvis::XDIR)   - sGstartr);
-          int sGoendc(sGoverlap.bigEnd(Amrvis::YDIR)   - sGstartc);
-          int sGoendp(sGoverlap.bigEnd(Amrvis::ZDIR)   - sGstartp);
-
-          grows = gbox.length(Amrvis::XDIR);
-          gcols = gbox.length(Amrvis::YDIR);
-
-        if(crr != 1) {
-          int sGcolsgrowstmp(gcols * grows);
-          for(gp = sGostartp; gp <= sGoendp; ++gp) {
-            if(gp == sGostartp || gp == sGoendp) {
-              edgep = 1;
-            } else {
-              edgep = 0;
-            }
-            gpgcgrtmp = gp * sGcolsgrowstmp;
-            for(gc = sGostartc; gc <= sGoendc; ++gc) {
-              if(gc == sGostartc || gc == sGoendc) {
-                edgec = 1;
-              } else {
-                edgec = 0;
-              }
-              for(gr = sGostartr; gr <= sGoendr; ++gr) {
-                if(gr == sGostartr || gr == sGoendr) {
-                  edger = 1;
-                } else {
-                  edger = 0;
-                }
-                sindexbase = (((gp + sGstartp) * crr - sstartp) * scolssrowstmp) +
-                             ((sendc - ((gc + sGstartc) * crr)) * srows) +
-                             ((gr + sGstartr) * crr - sstartr);
-
-              if((edger + edgec + edgep) > 1) {
-                // (possibly) draw boxes into dataset
-                int onEdger, onEdgec, onEdgep;
-
-                for(sp = 0; sp < crr; ++sp) {
-                  if((gp==sGostartp && sp==0) || (gp==sGoendp && sp == (crr-1))) {
-                    onEdgep = 1;
-                  } else {
-                    onEdgep = 0;
-                  }
-                  for(sc = 0; sc < crr; ++sc) {
-                    if((gc==sGostartc && sc==0) || (gc==sGoendc && sc == (crr-1))) {
-                      onEdgec = 1;
-                    } else {
-                      onEdgec = 0;
-                    }
-                    for(sr = 0; sr < crr; ++sr) {
-                      if((gr==sGostartr && sr==0) || (gr==sGoendr && sr == (crr-1))) {
-                        onEdger = 1;
-                      } else {
-                        onEdger = 0;
-                      }
-                      if((onEdger + onEdgec + onEdgep) > 1) {
-                        sindex = sindexbase + ((sp * scolssrowstmp) -
-                                               (sc * srows) + sr);
-                        swfData[sindex] = volumeBoxColor;
-                      }
-
-                    }
-                  }
-                }  // end for(sp...)
-              }
-              }
-            }
-          }  // end for(gp...)
-
-        } else {  // crr == 1
-
-          int sGcolsgrowstmp(gcols * grows);
-          for(gp = sGostartp; gp <= sGoendp; ++gp) {
-            if(gp == sGostartp || gp == sGoendp) {
-              edgep = 1;
-            } else {
-              edgep = 0;
-            }
-            gpgcgrtmp = gp * sGcolsgrowstmp;
-            for(gc = sGostartc; gc <= sGoendc; ++gc) {
-              if(gc == sGostartc || gc == sGoendc) {
-                edgec = 1;
-              } else {
-                edgec = 0;
-              }
-              for(gr = sGostartr; gr <= sGoendr; ++gr) {
-                if(gr == sGostartr || gr == sGoendr) {
-                  edger = 1;
-                } else {
-                  edger = 0;
-                }
-                if((edger + edgec + edgep) > 1) {
-                  sindexbase =
-                      (((gp + sGstartp) - sstartp) * scolssrowstmp) +
-                      ((sendc - ((gc + sGstartc))) * srows) +
-                      ((gr + sGstartr) - sstartr);
-                  swfData[sindexbase] = volumeBoxColor;
-                }
-              }
-            }
-          }  // end for(gp...)
-        }  // end if(crr...)
+        BurnInBoxEdges(swfData, swfDataBox, drawnDomain[lev], drawnDomain[lev],
+                       crr, false, volumeBoxColor);
 
      }  // end if(bDrawAllBoxes)
+      boxesTime = ParallelDescriptor::second() - boxesTime;
 
     }  // end if(bDrawVolumeBoxes)
 
@@ -573,70 +607,40 @@ void VolRender::MakeSWFData(amrex::DataServices *dataServicesPtr,
   AmrData &amrData = dataServicesPtr->AmrDataRef();
   const string vfracName = "vfrac";
   if(amrData.CartGrid() && derivedName != vfracName) {
-    // reuse swfFabData
-    amrex::DataServices::Dispatch(DataServices::FillVarOneFab, dataServicesPtr,
-                           (void *) &swfFabData,
-			   (void *) &swfDataBox,
-			   maxDrawnLevel,
-			   (void *) &vfracName);
-
-    if(ParallelDescriptor::IOProcessor()) {
-      char bodyColor = (char) palettePtr->BodyIndex();
-      Real *dataPoint = swfFabData.dataPtr();
-      Real vfeps = amrData.VfEps(maxDrawnLevel);
-      int sindexbase;
-      int srows   = swfDataBox.length(Amrvis::XDIR);
-      int scols   = swfDataBox.length(Amrvis::YDIR);
-      int scolssrowstmp = scols*srows;
-      int sstartr = swfDataBox.smallEnd(Amrvis::XDIR);
-      int sstartp = swfDataBox.smallEnd(Amrvis::ZDIR);
-      int sendc   = swfDataBox.bigEnd(Amrvis::YDIR);
-    
-      Box gbox(swfDataBox);
-      Box goverlap(gbox & drawnDomain[maxDrawnLevel]);
-    
-      int sGstartr = gbox.smallEnd(Amrvis::XDIR);
-      int sGstartc = gbox.smallEnd(Amrvis::YDIR);
-      int sGstartp = gbox.smallEnd(Amrvis::ZDIR);
-    
-      int sGostartr = goverlap.smallEnd(Amrvis::XDIR) - sGstartr;
-      int sGostartc = goverlap.smallEnd(Amrvis::YDIR) - sGstartc;
-      int sGostartp = goverlap.smallEnd(Amrvis::ZDIR) - sGstartp;
-      int sGoendr   = goverlap.bigEnd(Amrvis::XDIR)   - sGstartr;
-      int sGoendc   = goverlap.bigEnd(Amrvis::YDIR)   - sGstartc;
-      int sGoendp   = goverlap.bigEnd(Amrvis::ZDIR)   - sGstartp;
-    
-      int grows   = gbox.length(Amrvis::XDIR);
-      int gcols   = gbox.length(Amrvis::YDIR);
-    
-      int gcolsgrowstmp(gcols * grows);
-      int gpgcgrtmp, gcgrowstmp;
-      for(int gp(sGostartp); gp <= sGoendp; ++gp) {
-        gpgcgrtmp = gp*gcolsgrowstmp;
-        for(int gc(sGostartc); gc <= sGoendc; ++gc) {
-          gcgrowstmp = gpgcgrtmp + gc*grows;
-          for(int gr(sGostartr); gr <= sGoendr; ++gr) {
-            //dat = dataPoint[(gp*gcols*grows)+(gc*grows)+gr];  // works
-            if(dataPoint[gcgrowstmp + gr] < vfeps) {  // body
-	      int gprev = sGostartp + sGoendp - gp;
-              sindexbase =
-                (((gprev+sGstartp)-sstartp) * scolssrowstmp) +
-                ((sendc-((gc+sGstartc))) * srows) +  // check this
-                ((gr+sGstartr)-sstartr);
-          
-              swfData[sindexbase] = bodyColor;
-	    }
-          }
-        }
-      }  // end for(gp...)
-
-    }  // end if(ioproc)
+    bodyTime = ParallelDescriptor::second();
+    unsigned char bodyColor = (unsigned char) palettePtr->BodyIndex();
+    Real vfeps = amrData.VfEps(maxDrawnLevel);
+    // ---- reuse swfFabData, a brick at a time
+    for(int bzlo(swfDataBox.smallEnd(Amrvis::ZDIR)); bzlo <= sendp; bzlo += brickPlanes) {
+      Box brickBox(swfDataBox);
+      brickBox.setSmall(Amrvis::ZDIR, bzlo);
+      brickBox.setBig(Amrvis::ZDIR, std::min(bzlo + brickPlanes - 1, sendp));
+      if(ParallelDescriptor::IOProcessor()) {
+        swfFabData.resize(brickBox, 1);
+      }
+      amrex::DataServices::Dispatch(DataServices::FillVarOneFab, dataServicesPtr,
+                             (void *) &swfFabData,
+			     (void *) &brickBox,
+			     maxDrawnLevel,
+			     (void *) &vfracName);
+
+      if(ParallelDescriptor::IOProcessor()) {
+        BurnInBody(swfFabData, swfData, swfDataBox, vfeps, bodyColor);
+        ReleaseSWFPlanes(sendp - brickBox.bigEnd(Amrvis::ZDIR),
+                         brickBox.length(Amrvis::ZDIR));
+      }
+    }  // end for(bzlo...)
+    bodyTime = ParallelDescriptor::second() - bodyTime;
   }
 
   if(ParallelDescriptor::IOProcessor()) {
     cout << endl;
     cout << "--------------- make swfData time = "
-         << ((clock()-time0)/1000000.0) << endl;
+         << fillTime + quantizeTime + boxesTime + bodyTime << endl;
+    cout << "                fill = " << fillTime
+         << "  quantize = " << quantizeTime
+         << "  boxes = " << boxesTime
+         << "  body = " << bodyTime << endl;
   }
 
 }  // end MakeSWFData(...)
@@ -677,12 +681,14 @@ void VolRender::WriteSWFData(const string &filenamebase, bool SWFLight) {
 // -------------------------------------------------------------------
 void VolRender::InvalidateSWFData() {
   swfDataValid = false;
+  ++stateStamp;
 }
 
 
 // -------------------------------------------------------------------
 void VolRender::InvalidateVPData() {
   vpDataValid = false;
+  ++stateStamp;
 }
 
 
@@ -692,6 +698,7 @@ void VolRender::SetLightingModel(bool lightOn) {
     return;
   }
   lightingModel = lightOn;
+  ++stateStamp;
   if(lightingModel == true) {
     vpSetVoxelField(vpc, normalField, normalSize, normalOffset, maxShadeRampPts-1);
   } else {  // value model
@@ -703,6 +710,7 @@ void VolRender::SetLightingModel(bool lightOn) {
 // -------------------------------------------------------------------
 void VolRender::SetPreClassifyAlgorithm(bool pC) {
   preClassify = pC;
+  ++stateStamp;
 }
 
 
@@ -763,137 +771,96 @@ void VolRender::MakePicture(Real mvmat[4][4], Real Length, int width,
     }
 }
 
+// -------------------------------------------------------------------
+// ---- fill the value model voxels of swfData planes zfirst to
+// ---- zfirst + nplanes - 1.  the value model shades with the density
+// ---- itself.  the lighting model voxels are made by volpack, so its
+// ---- normal and gradient encoding is used.
+void VolRender::MakeRawVoxels(RawVoxel *voxels, int zfirst, int nplanes) const {
+  BL_ASSERT( ! lightingModel);
+  long planeSize(static_cast<long>(rows) * cols);
+  const unsigned char *slabData = swfData + zfirst * planeSize;
+  long nVoxels(nplanes * planeSize);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for(long v = 0; v < nVoxels; ++v) {
+    voxels[v].normal   = slabData[v];
+    voxels[v].density  = slabData[v];
+    voxels[v].gradient = 0;
+  }
+}
+
+
 // -------------------------------------------------------------------
 void VolRender::MakeVPData() {
   BL_ASSERT(bVolRenderDefined);
   if(ParallelDescriptor::IOProcessor()) {
-    clock_t time0 = clock();
+    double time0(ParallelDescriptor::second());
+    double voxelTime(0.0), classifyTime(0.0);
     
     vpDataValid = true;
     
-    cout << "vpClassifyScalars..." << endl;           // --- classify
+    if(AVGlobals::Verbose()) {
+      cout << "_in VolRender::MakeVPData:  classifying " << swfDataSize
+           << " voxels" << endl;
+    }
     
     vpSetd(vpc, VP_MIN_VOXEL_OPACITY, minRayOpacity);
     vpSetd(vpc, VP_MAX_RAY_OPACITY,   maxRayOpacity);
 
     vpResult vpret;
-    if(preClassify) {
-      if(lightingModel) {
-//  #define AV_LOWMEMRENDER
-#ifdef AV_LOWMEMRENDER
-        int xStride(sizeof(RawVoxel));
-        //int yStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) * sizeof(RawVoxel));
-        int yStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR));
-        //int zStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) *
-                    //drawnDomain[maxDataLevel].length(Amrvis::YDIR) * sizeof(RawVoxel));
-	long int nrc(drawnDomain[maxDataLevel].length(Amrvis::YDIR) *
-	             drawnDomain[maxDataLevel].length(Amrvis::ZDIR));
-	RawVoxel *vscanline = volData;
-	cout << "****** volData =  " << volData << endl;
-	cout << "****** classifying " << nrc << " scanlines." << endl;
-	for(int ix(0); ix < nrc; ++ix) {
-	//for(int iz(0); iz < drawnDomain[maxDataLevel].length(Amrvis::ZDIR); ++iz) {
-	  //for(int iy(0); iy < drawnDomain[maxDataLevel].length(Amrvis::YDIR); ++iy) {
-	    if(ix % 100 == 0) {
-	      cout << "----- vscanline = " << ix << endl;
-	    }
-            vpret = vpClassifyScanline(vpc, (void *) vscanline);
-            CheckVP(vpret, 6.05);
-	    vscanline += yStride;
-	  //}
-	}
-        //CheckVP(vpret, 6);
-
-
-        //vpret = vpClassifyScalars(vpc, swfData, swfDataSize,
-                                  //densityField, gradientField, normalField);
-        //CheckVP(vpret, 6);
-#else
-        vpret = vpClassifyScalars(vpc, swfData, swfDataSize,
-                                  densityField, gradientField, normalField);
-        CheckVP(vpret, 6);
-#endif
-      } else {  // value model
-#ifdef AV_LOWMEMRENDER
-        // the classification and loading of the value model
-        delete [] volData;
-        volData = new RawVoxel[swfDataSize]; // volpack will delete this
-        int xStride(sizeof(RawVoxel));
-        //int yStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) * sizeof(RawVoxel));
-        int yStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR));
-        int zStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) *
-                    drawnDomain[maxDataLevel].length(Amrvis::YDIR) * sizeof(RawVoxel));
-        vpret = vpSetRawVoxels(vpc, volData, swfDataSize * sizeof(RawVoxel),
-                               xStride, yStride, zStride);
-        CheckVP(vpret, 9.4);
-        for(int vindex(0); vindex < swfDataSize; ++vindex) {
-          volData[vindex].normal  = swfData[vindex];
-          volData[vindex].density = swfData[vindex];
-        }
-        
-	long int nrc(drawnDomain[maxDataLevel].length(Amrvis::YDIR) *
-	             drawnDomain[maxDataLevel].length(Amrvis::ZDIR));
-	RawVoxel *vscanline = volData;
-	cout << "****** classifying " << nrc << " scanlines." << endl;
-	for(int ix(0); ix < nrc; ++ix) {
-	  if(ix % 100 == 0) {
-	    cout << "----- vscanline = " << ix << endl;
-	  }
+    if(preClassify && lightingModel) {
+      classifyTime = ParallelDescriptor::second();
+      vpret = vpClassifyScalars(vpc, swfData, swfDataSize,
+                                densityField, gradientField, normalField);
+      CheckVP(vpret, 6);
+      classifyTime = ParallelDescriptor::second() - classifyTime;
+      ReleaseSWFPlanes(0, planes);
+    } else if(preClassify) {
+      // ---- volpack builds the classified volume one scanline at a time,
+      // ---- in order, so the voxels are made a slab of planes at a time
+      // ---- on several threads and then classified
+      long planeSize(static_cast<long>(rows) * cols);
+      int slabPlanes(static_cast<int>(std::min(static_cast<long>(planes),
+                                      std::max(1L, (4L * 1024L * 1024L) / planeSize))));
+      Vector<RawVoxel> slabVoxels(slabPlanes * planeSize);
+      for(int zfirst(0); zfirst < planes; zfirst += slabPlanes) {
+        int nplanes(std::min(slabPlanes, planes - zfirst));
+        double tVoxels(ParallelDescriptor::second());
+        MakeRawVoxels(slabVoxels.dataPtr(), zfirst, nplanes);
+        double tClassify(ParallelDescriptor::second());
+        voxelTime += tClassify - tVoxels;
+        RawVoxel *vscanline = slabVoxels.dataPtr();
+        for(int iline(0); iline < nplanes * cols; ++iline) {
           vpret = vpClassifyScanline(vpc, (void *) vscanline);
-          CheckVP(vpret, 9.5);
-	  vscanline += yStride;
-	}
-#else
-        // the classification and loading of the value model
-        delete [] volData;
-        volData = new RawVoxel[swfDataSize]; // volpack will delete this
-        int xStride(sizeof(RawVoxel));
-        int yStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) * sizeof(RawVoxel));
-        int zStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) *
-                    drawnDomain[maxDataLevel].length(Amrvis::YDIR) * sizeof(RawVoxel));
-        vpret = vpSetRawVoxels(vpc, volData, swfDataSize * sizeof(RawVoxel),
-                               xStride, yStride, zStride);
-        CheckVP(vpret, 9.4);
-        for(int vindex(0); vindex < swfDataSize; ++vindex) {
-          volData[vindex].normal  = swfData[vindex];
-          volData[vindex].density = swfData[vindex];
+          CheckVP(vpret, 6);
+          vscanline += rows;
         }
-        
-        vpret = vpClassifyVolume(vpc);
-        CheckVP(vpret, 9.5);
-#endif
-        
+        classifyTime += ParallelDescriptor::second() - tClassify;
+        ReleaseSWFPlanes(zfirst, nplanes);
       }
     } else {   // load the volume data and precompute the minmax octree
+      delete [] volData;
+      volData = new RawVoxel[swfDataSize]; 
+      int xStride(sizeof(RawVoxel));
+      int yStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) * sizeof(RawVoxel));
+      int zStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) *
+                  drawnDomain[maxDataLevel].length(Amrvis::YDIR) * sizeof(RawVoxel));
+      vpret = vpSetRawVoxels(vpc, volData, swfDataSize * sizeof(RawVoxel),
+                             xStride, yStride, zStride);
+      CheckVP(vpret, 9.4);
+      voxelTime = ParallelDescriptor::second();
       if(lightingModel) {
-        delete [] volData;
-        volData = new RawVoxel[swfDataSize]; 
-        int xStride(sizeof(RawVoxel));
-        int yStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) * sizeof(RawVoxel));
-        int zStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) *
-                    drawnDomain[maxDataLevel].length(Amrvis::YDIR) * sizeof(RawVoxel));
-        vpret = vpSetRawVoxels(vpc, volData, swfDataSize * sizeof(RawVoxel),
-                               xStride, yStride, zStride);
-        CheckVP(vpret, 9.45);
         vpret = vpVolumeNormals(vpc, swfData, swfDataSize,
                                 densityField, gradientField, normalField);
         CheckVP(vpret, 6.1);
-        
-      } else {  // value model
-        delete [] volData;
-        volData = new RawVoxel[swfDataSize]; 
-        int xStride(sizeof(RawVoxel));
-        int yStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) * sizeof(RawVoxel));
-        int zStride(drawnDomain[maxDataLevel].length(Amrvis::XDIR) *
-                    drawnDomain[maxDataLevel].length(Amrvis::YDIR) * sizeof(RawVoxel));
-        vpret = vpSetRawVoxels(vpc, volData, swfDataSize * sizeof(RawVoxel),
-                               xStride, yStride, zStride);
-        CheckVP(vpret, 9.4);
-        for(int vindex(0); vindex < swfDataSize; ++vindex) {
-          volData[vindex].normal  = swfData[vindex];
-          volData[vindex].density = swfData[vindex];
-        }
-      }     
+      } else {
+        MakeRawVoxels(volData, 0, planes);
+      }
+      voxelTime = ParallelDescriptor::second() - voxelTime;
+
+      classifyTime = ParallelDescriptor::second();
       vpret = vpMinMaxOctreeThreshold(vpc, DENSITY_PARAM, 
                                       OCTREE_DENSITY_THRESH);
       CheckVP(vpret, 9.41);
@@ -906,72 +873,221 @@ void VolRender::MakeVPData() {
       
       vpret = vpCreateMinMaxOctree(vpc, 1, OCTREE_BASE_NODE_SIZE);
       CheckVP(vpret, 9.43);
+      classifyTime = ParallelDescriptor::second() - classifyTime;
     }
     
-    // --- set the shading parameters
+    SetShadingTables();
 
-    if(lightingModel) {
-      vpret = vpSetLookupShader(vpc, 1, 1, normalField, shade_table.dataPtr(),
-                              maxShadeRampPts * sizeof(float), 0, NULL, 0);
-      CheckVP(vpret, 7);
-
-      vpSetMaterial(vpc, VP_MATERIAL0, VP_AMBIENT, VP_BOTH_SIDES,
-                    ambientMat, ambientMat, ambientMat);//0.28, 0.28, 0.28);
-      vpSetMaterial(vpc, VP_MATERIAL0, VP_DIFFUSE, VP_BOTH_SIDES, 
-                    diffuseMat, diffuseMat, diffuseMat);//0.35, 0.35, 0.35);
-      vpSetMaterial(vpc, VP_MATERIAL0, VP_SPECULAR, VP_BOTH_SIDES, 
-                    specularMat, specularMat, specularMat);//0.39, 0.39, 0.39);
-      vpSetMaterial(vpc, VP_MATERIAL0, VP_SHINYNESS, VP_BOTH_SIDES, 
-                    shinyMat, 0.0, 0.0);//10.0,  0.0, 0.0);
+    cout << "----- make vp data time = " << (ParallelDescriptor::second() - time0)
+         << "  (voxels = " << voxelTime << ", classify = " << classifyTime
+         << ")" << endl;
+  }
   
-      vpSetLight(vpc, VP_LIGHT0, VP_DIRECTION, 0.3, 0.3, 1.0);
-      vpSetLight(vpc, VP_LIGHT0, VP_COLOR, 1.0, 1.0, 1.0);
-      vpEnable(vpc, VP_LIGHT0, 1);
-        
-      vpSeti(vpc, VP_CONCAT_MODE, VP_CONCAT_LEFT);
-        
-      // --- compute shading lookup table
-      vpret = vpShadeTable(vpc);
-      CheckVP(vpret, 8);
-
-    } else {  // value model
-      BL_ASSERT(palettePtr != NULL);
-      for(int sn(0); sn < paletteSize; ++sn) {
-        value_shade_table[sn] = (float) sn;
-      }
-      value_shade_table[0] = (float) AVGlobals::MaxPaletteIndex();
-     
-      float maxf(0.0);
-      float minf(1000000.0);
-      for(int ijk(0); ijk < paletteSize; ++ijk) {
-        maxf = max(maxf, value_shade_table[ijk]);
-        minf = min(minf, value_shade_table[ijk]);
-      }
-      
-      vpret = vpSetLookupShader(vpc, 1, 1, normalField, 
-                                value_shade_table.dataPtr(),
-                                paletteSize * sizeof(float), 0, NULL, 0);
-      CheckVP(vpret, 9);
+}  // end MakeVPData()
+
+
+// -------------------------------------------------------------------
+// ---- set the shading parameters for the classified volume
+void VolRender::SetShadingTables() {
+  vpResult vpret;
+  if(lightingModel) {
+    vpret = vpSetLookupShader(vpc, 1, 1, normalField, shade_table.dataPtr(),
+                            maxShadeRampPts * sizeof(float), 0, NULL, 0);
+    CheckVP(vpret, 7);
+
+    vpSetMaterial(vpc, VP_MATERIAL0, VP_AMBIENT, VP_BOTH_SIDES,
+                  ambientMat, ambientMat, ambientMat);//0.28, 0.28, 0.28);
+    vpSetMaterial(vpc, VP_MATERIAL0, VP_DIFFUSE, VP_BOTH_SIDES, 
+                  diffuseMat, diffuseMat, diffuseMat);//0.35, 0.35, 0.35);
+    vpSetMaterial(vpc, VP_MATERIAL0, VP_SPECULAR, VP_BOTH_SIDES, 
+                  specularMat, specularMat, specularMat);//0.39, 0.39, 0.39);
+    vpSetMaterial(vpc, VP_MATERIAL0, VP_SHINYNESS, VP_BOTH_SIDES, 
+                  shinyMat, 0.0, 0.0);//10.0,  0.0, 0.0);
+
+    vpSetLight(vpc, VP_LIGHT0, VP_DIRECTION, 0.3, 0.3, 1.0);
+    vpSetLight(vpc, VP_LIGHT0, VP_COLOR, 1.0, 1.0, 1.0);
+    vpEnable(vpc, VP_LIGHT0, 1);
       
-      vpSetMaterial(vpc, VP_MATERIAL0, VP_AMBIENT, VP_BOTH_SIDES,
-                    ambientMat, ambientMat, ambientMat);//0.28, 0.28, 0.28);
-      vpSetMaterial(vpc, VP_MATERIAL0, VP_DIFFUSE, VP_BOTH_SIDES, 
-                    diffuseMat, diffuseMat, diffuseMat);//0.35, 0.35, 0.35);
-      vpSetMaterial(vpc, VP_MATERIAL0, VP_SPECULAR, VP_BOTH_SIDES, 
-                    specularMat, specularMat, specularMat);//0.39, 0.39, 0.39);
-      vpSetMaterial(vpc, VP_MATERIAL0, VP_SHINYNESS, VP_BOTH_SIDES, 
-                    shinyMat, 0.0, 0.0);//10.0,  0.0, 0.0);
-
-      vpSetLight(vpc, VP_LIGHT0, VP_DIRECTION, 0.3, 0.3, 1.0);
-      vpSetLight(vpc, VP_LIGHT0, VP_COLOR, 1.0, 1.0, 1.0);
-      vpEnable(vpc, VP_LIGHT0, 1);
+    vpSeti(vpc, VP_CONCAT_MODE, VP_CONCAT_LEFT);
       
-      vpSeti(vpc, VP_CONCAT_MODE, VP_CONCAT_LEFT);
+    // --- compute shading lookup table
+    vpret = vpShadeTable(vpc);
+    CheckVP(vpret, 8);
+
+  } else {  // value model
+    BL_ASSERT(palettePtr != NULL);
+    for(int sn(0); sn < paletteSize; ++sn) {
+      value_shade_table[sn] = (float) sn;
     }
-    cout << "----- make vp data time = " << ((clock()-time0)/1000000.0) << endl;
+    value_shade_table[0] = (float) AVGlobals::MaxPaletteIndex();
+   
+    float maxf(0.0);
+    float minf(1000000.0);
+    for(int ijk(0); ijk < paletteSize; ++ijk) {
+      maxf = max(maxf, value_shade_table[ijk]);
+      minf = min(minf, value_shade_table[ijk]);
+    }
+    
+    vpret = vpSetLookupShader(vpc, 1, 1, normalField, 
+                              value_shade_table.dataPtr(),
+                              paletteSize * sizeof(float), 0, NULL, 0);
+    CheckVP(vpret, 9);
+    
+    vpSetMaterial(vpc, VP_MATERIAL0, VP_AMBIENT, VP_BOTH_SIDES,
+                  ambientMat, ambientMat, ambientMat);//0.28, 0.28, 0.28);
+    vpSetMaterial(vpc, VP_MATERIAL0, VP_DIFFUSE, VP_BOTH_SIDES, 
+                  diffuseMat, diffuseMat, diffuseMat);//0.35, 0.35, 0.35);
+    vpSetMaterial(vpc, VP_MATERIAL0, VP_SPECULAR, VP_BOTH_SIDES, 
+                  specularMat, specularMat, specularMat);//0.39, 0.39, 0.39);
+    vpSetMaterial(vpc, VP_MATERIAL0, VP_SHINYNESS, VP_BOTH_SIDES, 
+                  shinyMat, 0.0, 0.0);//10.0,  0.0, 0.0);
+
+    vpSetLight(vpc, VP_LIGHT0, VP_DIRECTION, 0.3, 0.3, 1.0);
+    vpSetLight(vpc, VP_LIGHT0, VP_COLOR, 1.0, 1.0, 1.0);
+    vpEnable(vpc, VP_LIGHT0, 1);
+    
+    vpSeti(vpc, VP_CONCAT_MODE, VP_CONCAT_LEFT);
   }
-  
-}  // end MakeVPData()
+}
+
+
+// -------------------------------------------------------------------
+// ---- everything the preclassified volume is made from.  the shading
+// ---- tables are set after the volume is loaded, so the material
+// ---- properties are not part of the key.
+string VolRender::ClassifiedCacheKey(DataServices *dataServicesPtr,
+                                     Real rDataMin, Real rDataMax,
+                                     const string &derivedName,
+                                     int iPaletteStart, int iColorSlots,
+                                     bool bdrawboxes) const
+{
+  const string &plotFileName = dataServicesPtr->GetFileName();
+  std::ostringstream key;
+  key.precision(17);
+  key << plotFileName << ' ' << RangeIndex::HeaderTime(plotFileName)
+      << ' ' << derivedName << ' ' << maxDataLevel << ' '
+      << drawnDomain[maxDataLevel] << ' ' << rDataMin << ' ' << rDataMax
+      << ' ' << iPaletteStart << ' ' << iColorSlots << ' '
+      << palettePtr->BodyIndex() << ' ' << bdrawboxes << ' '
+      << AVGlobals::GetBoxColor() << ' ' << lightingModel << ' '
+      << minRayOpacity << ' ' << maxRayOpacity << ' ' << std::hex
+      << HashBytes(density_ramp.dataPtr(), density_ramp.size() * sizeof(float));
+  return key.str();
+}
+
+
+// -------------------------------------------------------------------
+string VolRender::ClassifiedCacheFileName(const string &cachekey) {
+  std::ostringstream fileName;
+  fileName << AVGlobals::ClassifyCacheDir() << '/' << std::hex
+           << HashBytes(cachekey.c_str(), cachekey.size()) << classifiedCacheSuffix;
+  return fileName.str();
+}
+
+
+// -------------------------------------------------------------------
+// ---- load the classified volume stored with cachekey.  returns
+// ---- false with no cache or a stale file, and the volume is made
+// ---- as usual.  all processors get the same answer.
+bool VolRender::LoadClassifiedVolume(const string &cachekey) {
+  BL_ASSERT(bVolRenderDefined);
+  if( ! preClassify || AVGlobals::ClassifyCacheDir().empty()) {
+    return false;
+  }
+  int iLoaded(0);
+  if(ParallelDescriptor::IOProcessor()) {
+    double time0(ParallelDescriptor::second());
+    string fileName(ClassifiedCacheFileName(cachekey));
+    int fd(-1);
+    if(PrivateCacheDir(AVGlobals::ClassifyCacheDir(), false)) {
+      fd = open(fileName.c_str(), O_RDONLY | O_NOFOLLOW);
+    }
+    struct stat st;
+    if(fd >= 0 && (fstat(fd, &st) != 0 || ! S_ISREG(st.st_mode) || ! PrivateStat(st))) {
+      close(fd);
+      fd = -1;
+    }
+    if(fd >= 0) {
+      // ---- the header line holds the whole key, so a hash
+      // ---- collision is a miss, not the wrong volume
+      string expected(classifiedCacheTag + ' ' +
+                      std::to_string(classifiedCacheVersion) + ' ' + cachekey);
+      string header;
+      char c;
+      while(header.size() <= expected.size() && read(fd, &c, 1) == 1 && c != '\n') {
+        header += c;
+      }
+      if(header == expected) {
+        vpSetd(vpc, VP_MIN_VOXEL_OPACITY, minRayOpacity);
+        vpSetd(vpc, VP_MAX_RAY_OPACITY,   maxRayOpacity);
+        if(vpLoadClassifiedVolume(vpc, fd) == VP_OK) {
+          SetShadingTables();
+          futimens(fd, nullptr);  // ---- recently used, for EvictCacheFiles
+          iLoaded = 1;
+        }
+      }
+      close(fd);
+    }
+    if(AVGlobals::Verbose()) {
+      cout << "_in VolRender::LoadClassifiedVolume:  " << fileName
+           << (iLoaded ? " loaded in " : " not used, ")
+           << (ParallelDescriptor::second() - time0) << " s" << endl;
+    }
+  }
+  ParallelDescriptor::Bcast(&iLoaded, 1, ParallelDescriptor::IOProcessorNumber());
+  if(iLoaded) {
+    vpDataValid = true;
+  }
+  return (iLoaded != 0);
+}
+
+
+// -------------------------------------------------------------------
+// ---- store the classified volume made by MakeVPData for later runs.
+// ---- a cache that cannot be written is not an error.
+void VolRender::StoreClassifiedVolume(const string &cachekey) {
+  BL_ASSERT(bVolRenderDefined);
+  if( ! preClassify || ! vpDataValid || AVGlobals::ClassifyCacheDir().empty() ||
+      ! ParallelDescriptor::IOProcessor())
+  {
+    return;
+  }
+  const string &cacheDir = AVGlobals::ClassifyCacheDir();
+  if( ! PrivateCacheDir(cacheDir, true)) {
+    cerr << "Warning:  not using classify cache directory " << cacheDir
+         << ":  it must be a directory owned by you and writable only by you."
+         << endl;
+    return;
+  }
+  long maxBytes(AVGlobals::ClassifyCacheMB() * 1024L * 1024L);
+  string fileName(ClassifiedCacheFileName(cachekey));
+  // ---- written under a temporary name so a reader never sees part of it
+  string tempFileName(fileName + ".tmp" + std::to_string(getpid()));
+  int fd(-1);
+  if(maxBytes > 0) {
+    fd = open(tempFileName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+  }
+  bool bStored(false);
+  if(fd >= 0) {
+    string header(classifiedCacheTag + ' ' +
+                  std::to_string(classifiedCacheVersion) + ' ' + cachekey + '\n');
+    bStored = (write(fd, header.c_str(), header.size()) ==
+               static_cast<ssize_t>(header.size())) &&
+              (vpStoreClassifiedVolume(vpc, fd) == VP_OK);
+    bStored = (close(fd) == 0) && bStored;
+    bStored = bStored && (rename(tempFileName.c_str(), fileName.c_str()) == 0);
+    if( ! bStored) {
+      unlink(tempFileName.c_str());
+    }
+  }
+  if(AVGlobals::Verbose()) {
+    cout << "_in VolRender::StoreClassifiedVolume:  "
+         << (bStored ? "stored " : "could not store ") << fileName << endl;
+  }
+  if(bStored) {
+    EvictCacheFiles(cacheDir, maxBytes);
+  }
+}
 
 
 // -------------------------------------------------------------------
@@ -1015,6 +1131,7 @@ void VolRender::SetTransferProperties() {
 
   vpSetd(vpc, VP_MIN_VOXEL_OPACITY, minRayOpacity);
   vpSetd(vpc, VP_MAX_RAY_OPACITY,   maxRayOpacity);
+  ++stateStamp;
 }
 
 
@@ -1055,6 +1172,7 @@ void VolRender::SetLighting(Real ambient, Real diffuse,
   shinyMat = shiny;
   minRayOpacity = (float) minRay;
   maxRayOpacity = (float) maxRay;
+  ++stateStamp;
 }
 // -------------------------------------------------------------------
 // -------------------------------------------------------------------
@@ -0,0 +1,96 @@
+#!/bin/sh
+# ---------------------------------------------------------------
+# animstartup.sh
+# ---------------------------------------------------------------
+# ---- times amrvis animation startup over a synthetic plot file series.
+# ---- one small 2d plot file is written, and the series is made of
+# ---- links to it, so thousands of files cost almost no disk.  amrvis
+# ---- is run with -a -v and stopped once it prints that the animation
+# ---- window is ready.  an X display is needed.
+# ----
+# ---- usage:  animstartup.sh amrvis2d_executable [nfiles [workdir]]
+# ---------------------------------------------------------------
+
+if [ $# -lt 1 ]; then
+  echo "usage:  $0 amrvis2d_executable [nfiles [workdir]]"
+  exit 1
+fi
+amrvis=$1
+nfiles=${2:-5000}
+workdir=${3:-/tmp/amrvisbench.$$}
+timeout=600
+
+mkdir -p "$workdir" || exit 1
+cd "$workdir" || exit 1
+
+# ---- the plot file:  one level, one 64x64 grid, one component
+if [ ! -f pltbase/Header ]; then
+  mkdir -p pltbase/Level_0
+  cat > pltbase/Header << EOF
+HyperCLaw-V1.1
+1
+density
+2
+0
+0
+0 0
+1 1
+
+((0,0) (63,63) (0,0))
+0
+0.015625 0.015625
+0
+0
+0 1 0
+0
+0 1
+0 1
+Level_0/Cell
+EOF
+  cat > pltbase/Level_0/Cell_H << EOF
+1
+0
+1
+0
+(1 0
+((0,0) (63,63) (0,0))
+)
+1
+FabOnDisk: Cell_D_00000 0
+
+1,1
+0,
+
+1,1
+4095,
+EOF
+  printf 'FAB ((8, (64 11 52 0 1 12 0 1023)),(8, (8 7 6 5 4 3 2 1)))((0,0) (63,63) (0,0)) 1\n' \
+    > pltbase/Level_0/Cell_D_00000
+  python3 -c "import struct, sys; sys.stdout.buffer.write(struct.pack('<4096d', *range(4096)))" \
+    >> pltbase/Level_0/Cell_D_00000 || exit 1
+fi
+
+i=0
+while [ $i -lt $nfiles ]; do
+  name=$(printf 'plt%05d' $i)
+  [ -e $name ] || ln -s pltbase $name
+  i=$((i + 1))
+done
+
+log=animstartup.log
+"$amrvis" -a -v plt[0-9]* > $log 2>&1 &
+pid=$!
+elapsed=0
+while ! grep -q "animation window ready" $log; do
+  if ! kill -0 $pid 2> /dev/null || [ $elapsed -ge $timeout ]; then
+    echo "amrvis did not open the animation window, see $workdir/$log"
+    kill $pid 2> /dev/null
+    exit 1
+  fi
+  sleep 1
+  elapsed=$((elapsed + 1))
+done
+kill $pid 2> /dev/null
+
+echo "$nfiles files:"
+grep "_in main:" $log